@@ -8,6 +8,7 @@
 #include <string>
 #include <algorithm>
 #include <atomic>
+#include "../hvac_bench.h" // makeBenchVariant() for -DHVAC_BENCH builds
 
 using namespace std;
 
@@ -239,8 +240,31 @@ public:
     }
 };
 
+#ifdef HVAC_BENCH
+// Bench entry point (see hvac_bench.h), built in place of main(). No
+// renderAll op: ModeControlScreen::render re-locks its own mutex through
+// getModeString() and deadlocks.
+Variant makeBenchVariant() {
+    struct State {
+        shared_ptr<TemperatureControlScreen> temp = make_shared<TemperatureControlScreen>();
+        shared_ptr<FanSpeedControlScreen> fan = make_shared<FanSpeedControlScreen>();
+        shared_ptr<ModeControlScreen> mode = make_shared<ModeControlScreen>();
+    };
+    auto s = make_shared<State>();
+    State* p = s.get();
+    return Variant{"today",
+                   {{"setTemperature", OpKind::Write, [p](unsigned v) { p->temp->setTargetTemp(16.0 + v % 15); }},
+                    {"getTemperature", OpKind::Read, [p](unsigned) { (void)p->temp->getCurrentTemp(); }},
+                    {"setFanLevel", OpKind::Write, [p](unsigned v) { p->fan->setFanSpeed(static_cast<int>(v % 6)); }},
+                    {"getFanLevel", OpKind::Read, [p](unsigned) { (void)p->fan->getFanSpeed(); }},
+                    {"setMode", OpKind::Write, [p](unsigned v) { p->mode->setMode(static_cast<ModeControlScreen::Mode>(v % 3)); }},
+                    {"getMode", OpKind::Read, [p](unsigned) { (void)p->mode->getCurrentMode(); }}},
+                   s};
+}
+#else
 int main() {
     ClimateControlManager manager;
     manager.startSimulation();
     return 0;
-}
\ No newline at end of file
+}
+#endif // HVAC_BENCH
@@ -4,13 +4,21 @@
 #include <deque>
 #include <list>
 #include <string>
+#include <sstream>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <chrono>
-#include <random>
 #include <algorithm>
+#include "../hvac_task_pool.h" // Work-stealing pool for updateAllSettings
+#include "../hvac_change_bus.h" // Coalesced wake-up for the render thread
+#include "../hvac_frame_writer.h" // Diffed full-screen frames, one write per frame
+#include "../hvac_random.h" // Per-control reproducible PRNG streams
+#include "../hvac_periodic.h" // Deadline-grid loops with jitter stats
+#include "../hvac_thread_placement.h" // HVAC_PLACEMENT pinning and SCHED_FIFO
+#include "../hvac_thermal_model.h" // PID-driven cabin temperature
+#include "../hvac_bench.h" // makeBenchVariant() for -DHVAC_BENCH builds
 
 // External variable declaration (simulated)
 extern int fanLimit = 5;
@@ -22,20 +30,52 @@ protected:
     int controlId;
     mutable int logCount = 0; // mutable for logging in const methods
     
+    // Called by subclasses after their state changes (not on every update).
+    // Only the first change since the last render wakes the render thread.
+    void markDirty() {
+        if (!dirty.exchange(true)) {
+            if (ChangeBus* bus = changes.load()) {
+                bus->publish(FRAME_CHANGED);
+            }
+        }
+    }
+    
+private:
+    std::atomic<bool> dirty{true}; // Starts dirty so the first frame draws it
+    std::atomic<ChangeBus*> changes{nullptr}; // Set by the owning manager
+    std::string section; // Last render(), reused while the control is clean
+    
 public:
+    static constexpr ChangeMask FRAME_CHANGED = 1;
+    
     HVACControl() : controlId(++idCounter) {}
     virtual ~HVACControl() = default;
     
     // Pure virtual functions
-    virtual void render() const = 0;
+    virtual void render(std::ostream& out) const = 0;
+    void render() const { render(std::cout); }
     virtual void updateSettings() = 0;
     virtual std::string getName() const = 0;
     
     int getId() const { return controlId; }
     
-    void log(const std::string& message) const {
+    void attach(ChangeBus* bus) { changes.store(bus); }
+    
+    // The control's part of the frame, re-rendered only if it changed since
+    // the last call. Clears the flag before rendering so a change made
+    // meanwhile is picked up next frame. Render thread only.
+    const std::string& renderedSection() {
+        if (dirty.exchange(false)) {
+            std::ostringstream out;
+            render(out);
+            section = out.str();
+        }
+        return section;
+    }
+    
+    void log(std::ostream& out, const std::string& message) const {
         logCount++; // mutable allows modification in const method
-        std::cout << "[LOG " << logCount << "] " << message << std::endl;
+        out << "[LOG " << logCount << "] " << message << '\n';
     }
 };
 
@@ -50,38 +90,52 @@ private:
     double targetTemp;
     std::deque<int> temperatureHistory; // Last N temperature readings
     static const size_t MAX_HISTORY = 10;
+    // The cabin as a one-zone thermal model: the PID drives currentTemp
+    // toward targetTemp; ambient stays at the starting temperature.
+    ZoneThermalBatch thermal;
+    std::size_t zone;
     
 public:
+    static constexpr float UPDATE_PERIOD_SECONDS = 2.0f; // updateThread's period
+    
     TemperatureControlScreen(double initial = 22.0) 
-        : currentTemp(initial), targetTemp(initial) {}
+        : currentTemp(initial), targetTemp(initial),
+          zone(thermal.addZone(static_cast<float>(initial), static_cast<float>(initial), static_cast<float>(initial),
+                               PidGains{5.0f, 0.02f, 0.0f})) {} // Tuned for 2 s steps: settles without overshoot
     
-    void render() const override {
+    void render(std::ostream& out) const override {
         std::lock_guard<std::mutex> lock(tempMutex);
-        log("Rendering Temperature Control");
-        std::cout << "=== TEMPERATURE CONTROL ===" << std::endl;
-        std::cout << "Current: " << currentTemp << "°C" << std::endl;
-        std::cout << "Target:  " << targetTemp << "°C" << std::endl;
-        std::cout << "History: ";
+        log(out, "Rendering Temperature Control");
+        out << "=== TEMPERATURE CONTROL ===" << '\n';
+        out << "Current: " << currentTemp << "°C" << '\n';
+        out << "Target:  " << targetTemp << "°C" << '\n';
+        out << "History: ";
         for (auto temp : temperatureHistory) {
-            std::cout << temp << "° ";
+            out << temp << "° ";
         }
-        std::cout << std::endl << std::endl;
+        out << "\n\n";
     }
     
     void updateSettings() override {
-        std::lock_guard<std::mutex> lock(tempMutex);
-        // Simulate temperature change towards target
-        if (currentTemp < targetTemp) {
-            currentTemp += 0.5;
-        } else if (currentTemp > targetTemp) {
-            currentTemp -= 0.5;
-        }
+        std::unique_lock<std::mutex> lock(tempMutex);
+        // One PID and plant step toward the target
+        thermal.step(UPDATE_PERIOD_SECONDS);
+        double previous = currentTemp;
+        currentTemp = thermal.temperature(zone);
         
-        // Add to history
-        temperatureHistory.push_back(static_cast<int>(currentTemp));
+        // Add to history; a full history of the same reading doesn't change
+        int reading = static_cast<int>(currentTemp);
+        bool changed = currentTemp != previous || temperatureHistory.size() < MAX_HISTORY ||
+                       std::any_of(temperatureHistory.begin(), temperatureHistory.end(),
+                                   [reading](int t) { return t != reading; });
+        temperatureHistory.push_back(reading);
         if (temperatureHistory.size() > MAX_HISTORY) {
             temperatureHistory.pop_front();
         }
+        lock.unlock();
+        if (changed) {
+            markDirty();
+        }
     }
     
     std::string getName() const override {
@@ -89,8 +143,15 @@ public:
     }
     
     void setTargetTemp(double temp) {
-        std::lock_guard<std::mutex> lock(tempMutex);
-        targetTemp = temp;
+        {
+            std::lock_guard<std::mutex> lock(tempMutex);
+            if (temp == targetTemp) {
+                return;
+            }
+            targetTemp = temp;
+            thermal.setSetpoint(zone, static_cast<float>(temp));
+        }
+        markDirty();
     }
     
     double getCurrentTemp() const {
@@ -107,36 +168,43 @@ private:
     mutable std::mutex fanMutex;
     int fanSpeed; // 0-5
     bool autoMode;
+    Xoshiro256pp gen; // Own stream keyed by control id; HVAC_SEED makes runs repeatable
     
 public:
     FanSpeedControlScreen(int initial = 2) 
-        : fanSpeed(initial), autoMode(false) {}
+        : fanSpeed(initial), autoMode(false),
+          gen(Xoshiro256pp::forStream(Xoshiro256pp::processSeed(), static_cast<std::uint64_t>(controlId))) {}
     
-    void render() const override {
+    void render(std::ostream& out) const override {
         std::lock_guard<std::mutex> lock(fanMutex);
-        log("Rendering Fan Speed Control");
-        std::cout << "=== FAN SPEED CONTROL ===" << std::endl;
-        std::cout << "Speed: " << fanSpeed << "/" << fanLimit << std::endl;
-        std::cout << "Mode:  " << (autoMode ? "AUTO" : "MANUAL") << std::endl;
-        std::cout << "Visual: ";
+        log(out, "Rendering Fan Speed Control");
+        out << "=== FAN SPEED CONTROL ===" << '\n';
+        out << "Speed: " << fanSpeed << "/" << fanLimit << '\n';
+        out << "Mode:  " << (autoMode ? "AUTO" : "MANUAL") << '\n';
+        out << "Visual: ";
         for (int i = 0; i < fanSpeed; i++) {
-            std::cout << "█";
+            out << "█";
         }
         for (int i = fanSpeed; i < fanLimit; i++) {
-            std::cout << "░";
+            out << "░";
         }
-        std::cout << std::endl << std::endl;
+        out << "\n\n";
     }
     
     void updateSettings() override {
-        std::lock_guard<std::mutex> lock(fanMutex);
-        if (autoMode) {
+        {
+            std::lock_guard<std::mutex> lock(fanMutex);
+            if (!autoMode) {
+                return;
+            }
             // Auto adjustment logic
-            static std::random_device rd;
-            static std::mt19937 gen(rd());
-            std::uniform_int_distribution<> dis(1, fanLimit);
-            fanSpeed = dis(gen);
+            int speed = gen.range(1, fanLimit);
+            if (speed == fanSpeed) {
+                return;
+            }
+            fanSpeed = speed;
         }
+        markDirty();
     }
     
     std::string getName() const override {
@@ -144,13 +212,23 @@ public:
     }
     
     void setFanSpeed(int speed) {
-        std::lock_guard<std::mutex> lock(fanMutex);
-        fanSpeed = std::max(0, std::min(speed, fanLimit));
+        {
+            std::lock_guard<std::mutex> lock(fanMutex);
+            speed = std::max(0, std::min(speed, fanLimit));
+            if (speed == fanSpeed) {
+                return;
+            }
+            fanSpeed = speed;
+        }
+        markDirty();
     }
     
     void toggleAutoMode() {
-        std::lock_guard<std::mutex> lock(fanMutex);
-        autoMode = !autoMode;
+        {
+            std::lock_guard<std::mutex> lock(fanMutex);
+            autoMode = !autoMode;
+        }
+        markDirty();
     }
     
     std::mutex& getMutex() { return fanMutex; }
@@ -164,6 +242,7 @@ private:
     ClimateMode currentMode;
     std::list<std::string> modeHistory; // Mode change history
     static const size_t MAX_MODE_HISTORY = 5;
+    Xoshiro256pp gen; // Own stream keyed by control id; HVAC_SEED makes runs repeatable
     
     std::string modeToString(ClimateMode mode) const {
         switch (mode) {
@@ -177,37 +256,38 @@ private:
     
 public:
     ModeControlScreen(ClimateMode initial = ClimateMode::AUTO) 
-        : currentMode(initial) {
+        : currentMode(initial),
+          gen(Xoshiro256pp::forStream(Xoshiro256pp::processSeed(), static_cast<std::uint64_t>(controlId))) {
         modeHistory.push_back(modeToString(initial));
     }
     
-    void render() const override {
+    void render(std::ostream& out) const override {
         std::lock_guard<std::mutex> lock(modeMutex);
-        log("Rendering Mode Control");
-        std::cout << "=== MODE CONTROL ===" << std::endl;
-        std::cout << "Current Mode: " << modeToString(currentMode) << std::endl;
-        std::cout << "History: ";
+        log(out, "Rendering Mode Control");
+        out << "=== MODE CONTROL ===" << '\n';
+        out << "Current Mode: " << modeToString(currentMode) << '\n';
+        out << "History: ";
         for (const auto& mode : modeHistory) {
-            std::cout << mode << " -> ";
+            out << mode << " -> ";
         }
-        std::cout << "CURRENT" << std::endl << std::endl;
+        out << "CURRENT" << "\n\n";
     }
     
     void updateSettings() override {
-        std::lock_guard<std::mutex> lock(modeMutex);
-        // Randomly change mode for simulation
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(0, 3);
-        
-        ClimateMode newMode = static_cast<ClimateMode>(dis(gen));
-        if (newMode != currentMode) {
+        {
+            std::lock_guard<std::mutex> lock(modeMutex);
+            // Randomly change mode for simulation
+            ClimateMode newMode = static_cast<ClimateMode>(gen.range(0, 3));
+            if (newMode == currentMode) {
+                return;
+            }
             currentMode = newMode;
             modeHistory.push_back(modeToString(currentMode));
             if (modeHistory.size() > MAX_MODE_HISTORY) {
                 modeHistory.pop_front();
             }
         }
+        markDirty();
     }
     
     std::string getName() const override {
@@ -215,14 +295,18 @@ public:
     }
     
     void setMode(int mode) {
-        std::lock_guard<std::mutex> lock(modeMutex);
-        if (mode >= 0 && mode <= 3) {
+        if (mode < 0 || mode > 3) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(modeMutex);
             currentMode = static_cast<ClimateMode>(mode);
-            modeHistory.push_back(modeToString(currentMode));
+            modeHistory.push_back(modeToString(currentMode)); // Always extends the history
             if (modeHistory.size() > MAX_MODE_HISTORY) {
                 modeHistory.pop_front();
             }
         }
+        markDirty();
     }
 };
 
@@ -231,16 +315,28 @@ class ClimateControlManager {
 private:
     std::vector<std::shared_ptr<HVACControl>> controls;
     mutable std::mutex managerMutex;
-    std::condition_variable cv;
+    ChangeBus changes; // Controls publish here when they become dirty
+    ChangeBus::Subscription frameChanges = changes.subscribe(HVACControl::FRAME_CHANGED);
     std::atomic<bool> keepRunning{true};
+    std::unique_ptr<WorkStealingPool> updatePool; // Built by the first updateAllSettings(), not per manager
+    FrameCompositor frame; // Reused screen buffer; HVAC_HEADLESS=1 skips the terminal
+    static const size_t UPDATE_CHUNK = 64; // Controls per stealable task
     
     // For deadlock demonstration
     std::mutex mutex1, mutex2;
     
 public:
+    ~ClimateControlManager() {
+        for (auto& control : controls) {
+            control->attach(nullptr);
+        }
+    }
+    
     void addControl(std::shared_ptr<HVACControl> control) {
         std::lock_guard<std::mutex> lock(managerMutex);
+        control->attach(&changes);
         controls.push_back(control);
+        changes.publish(HVACControl::FRAME_CHANGED); // Draw the new control
         std::cout << "Added control: " << control->getName() 
                   << " (ID: " << control->getId() << ")" << std::endl;
     }
@@ -253,22 +349,26 @@ public:
             });
         
         if (it != controls.end()) {
+            std::for_each(it, controls.end(), [](const std::shared_ptr<HVACControl>& control) { control->attach(nullptr); });
             controls.erase(it, controls.end());
+            changes.publish(HVACControl::FRAME_CHANGED);
             std::cout << "Removed control: " << controlName << std::endl;
         }
     }
     
     void renderAll() {
         std::lock_guard<std::mutex> lock(managerMutex);
-        system("clear"); // Linux/Mac - use "cls" for Windows
-        std::cout << "╔══════════════════════════════════════╗" << std::endl;
-        std::cout << "║     AUTOMOTIVE CLIMATE CONTROL      ║" << std::endl;
-        std::cout << "╚══════════════════════════════════════╝" << std::endl;
-        std::cout << std::endl;
+        // Compose the whole screen in memory; present() writes only what changed
+        std::ostream& out = frame.begin();
+        out << "╔══════════════════════════════════════╗" << '\n';
+        out << "║     AUTOMOTIVE CLIMATE CONTROL      ║" << '\n';
+        out << "╚══════════════════════════════════════╝" << '\n';
+        out << '\n';
         
-        // Use auto for iteration (storage class demonstration)
+        // Use auto for iteration (storage class demonstration); clean
+        // controls reuse their last section instead of rendering again
         for (auto& control : controls) {
-            control->render();
+            out << control->renderedSection();
         }
         
         // Register variable demonstration (deprecated but requested)
@@ -276,30 +376,40 @@ public:
         for (const auto& control : controls) {
             counter++; // Simple counter using register variable
         }
-        std::cout << "Total controls rendered: " << counter << std::endl;
-        std::cout << "Press Ctrl+C to exit..." << std::endl;
+        out << "Total controls rendered: " << counter << '\n';
+        out << "Press Ctrl+C to exit..." << '\n';
+        frame.present();
     }
     
+    // Controls only lock their own mutex in updateSettings(), so chunks of the
+    // list update in parallel. parallelFor() returns once every chunk is done,
+    // and renderAll() waits for managerMutex, so a frame never shows half a pass.
     void updateAllSettings() {
         std::lock_guard<std::mutex> lock(managerMutex);
-        for (auto& control : controls) {
-            control->updateSettings();
+        if (!updatePool) {
+            updatePool = std::make_unique<WorkStealingPool>();
         }
-        cv.notify_all();
+        updatePool->parallelFor(controls.size(), UPDATE_CHUNK, [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                controls[i]->updateSettings();
+            }
+        });
     }
     
     void stop() {
         keepRunning = false;
-        cv.notify_all();
+        changes.close();
     }
     
     bool isRunning() const {
         return keepRunning;
     }
     
-    void waitForUpdate() {
-        std::unique_lock<std::mutex> lock(managerMutex);
-        cv.wait(lock);
+    // Blocks until some control has changed since the last wait. Changes made
+    // while the caller was busy rendering coalesce into one wake-up. Returns
+    // false once stop() has been called.
+    bool waitForUpdate() {
+        return frameChanges.wait() != 0 && isRunning();
     }
     
     // Deadlock demonstration functions
@@ -348,33 +458,68 @@ public:
     }
 };
 
-// Thread functions for simulation
-void temperatureUpdateThread(std::shared_ptr<TemperatureControlScreen> tempControl, 
-                           ClimateControlManager& manager) {
-    while (manager.isRunning()) {
-        tempControl->updateSettings();
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-    }
-}
-
-void fanAndModeUpdateThread(std::shared_ptr<FanSpeedControlScreen> fanControl,
-                          std::shared_ptr<ModeControlScreen> modeControl,
-                          ClimateControlManager& manager) {
+// Thread function for simulation: one updateAllSettings() pass over every
+// control per tick, finished before the next frame is drawn
+void updateThread(ClimateControlManager& manager) {
+    applyThreadPlacement(ThreadRole::Control, std::cerr);
+    PeriodicTimer timer("updateThread", std::chrono::seconds(2));  // UPDATE_PERIOD_SECONDS; fixed grid, no drift
     while (manager.isRunning()) {
-        fanControl->updateSettings();
-        modeControl->updateSettings();
-        std::this_thread::sleep_for(std::chrono::seconds(3));
+        manager.updateAllSettings();
+        timer.wait();
     }
 }
 
+// Draws the first frame, then one frame per coalesced batch of changes
+// instead of repainting on a timer
 void renderThread(ClimateControlManager& manager) {
-    while (manager.isRunning()) {
+    applyThreadPlacement(ThreadRole::Render, std::cerr);
+    manager.renderAll();
+    while (manager.waitForUpdate()) {
         manager.renderAll();
-        std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 }
 
+#ifdef HVAC_BENCH
+// Bench entry point (see hvac_bench.h), built in place of main(). There are
+// no fan/mode getters to measure. updateAllSettings runs over a separate fleet
+// large enough to split into chunks, so its latency includes the pool's join.
+Variant makeBenchVariant() {
+    static const int BENCH_FLEET = 1024;
+    struct State {
+        ClimateControlManager manager;
+        ClimateControlManager fleet;
+        std::shared_ptr<TemperatureControlScreen> temp = std::make_shared<TemperatureControlScreen>(22.0);
+        std::shared_ptr<FanSpeedControlScreen> fan = std::make_shared<FanSpeedControlScreen>(2);
+        std::shared_ptr<ModeControlScreen> mode = std::make_shared<ModeControlScreen>();
+        State() {
+            manager.addControl(temp);
+            manager.addControl(fan);
+            manager.addControl(mode);
+            for (int i = 0; i < BENCH_FLEET; ++i) {
+                fleet.addControl(std::make_shared<TemperatureControlScreen>(22.0));
+            }
+        }
+    };
+    auto s = std::make_shared<State>();
+    State* p = s.get();
+    return Variant{"today2",
+                   {{"setTemperature", OpKind::Write, [p](unsigned v) { p->temp->setTargetTemp(16.0 + v % 15); }},
+                    {"getTemperature", OpKind::Read, [p](unsigned) { (void)p->temp->getCurrentTemp(); }},
+                    {"setFanLevel", OpKind::Write, [p](unsigned v) { p->fan->setFanSpeed(static_cast<int>(v % 6)); }},
+                    {"setMode", OpKind::Write, [p](unsigned v) { p->mode->setMode(static_cast<int>(v % 4)); }},
+                    {"renderAll", OpKind::Render, [p](unsigned) { p->manager.renderAll(); }},
+                    {"updateAllSettings", OpKind::Render, [p](unsigned) { p->fleet.updateAllSettings(); }}},
+                   s};
+}
+#else
 int main() {
+    try {
+        PlacementConfig::current() = PlacementConfig::fromEnvironment();
+    } catch (const std::exception& e) {
+        std::cerr << "HVAC_PLACEMENT: " << e.what() << std::endl;
+        return 1;
+    }
+    applyMemoryLock(std::cerr);
     std::cout << "Starting Automotive Climate Control System..." << std::endl;
     
     // Create manager
@@ -402,8 +547,7 @@ int main() {
     std::cout << "\nStarting simulation threads..." << std::endl;
     
     // Create simulation threads
-    std::thread tempThread(temperatureUpdateThread, sharedTempControl, std::ref(manager));
-    std::thread fanModeThread(fanAndModeUpdateThread, sharedFanControl, sharedModeControl, std::ref(manager));
+    std::thread controlThread(updateThread, std::ref(manager));
     std::thread displayThread(renderThread, std::ref(manager));
     
     // Run simulation for a limited time
@@ -414,11 +558,12 @@ int main() {
     manager.stop();
     
     // Safely join threads
-    if (tempThread.joinable()) tempThread.join();
-    if (fanModeThread.joinable()) fanModeThread.join();
+    if (controlThread.joinable()) controlThread.join();
     if (displayThread.joinable()) displayThread.join();
     
+    LoopStats::reportAll(std::cout);
     std::cout << "System shutdown complete." << std::endl;
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // HVAC_BENCH
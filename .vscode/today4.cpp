@@ -6,17 +6,42 @@
 #include <string>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
 #include <atomic>
-#include <random>
 #include <chrono>
 #include <algorithm>
+#include "../hvac_task_pool.h" // Work-stealing pool for updateAllSettings
+#include "../hvac_control_registry.h" // O(1) lookup by name and type
+#include "../hvac_frame_writer.h" // Diffed full-screen frames, one write per frame
+#include "../hvac_change_bus.h" // Coalesced change notifications
+#include "../hvac_epoch.h" // Lock-free published control list
+#include "../hvac_random.h" // Per-control xoshiro256++ streams
+#include "../hvac_coroutine.h" // Event-loop updaters in C++20 builds
+#include "../hvac_input_trace.h" // --record / --replay of setter calls
+#include "../hvac_periodic.h" // Deadline-grid loops with jitter stats
+#include "../hvac_thread_placement.h" // HVAC_PLACEMENT pinning and SCHED_FIFO
+#include "../hvac_bench.h" // makeBenchVariant() for -DHVAC_BENCH builds
 using namespace std;
 
 // External variable simulation (would normally be in another file)
 extern int fanLimit;
 int fanLimit = 5;
 
+// Set by --record FILE; every setter call is traced for --replay
+unique_ptr<InputRecorder> inputRecorder;
+
+void recordInput(InputKind kind, int value) {
+    if (inputRecorder) {
+        inputRecorder->record(kind, value);
+    }
+}
+
+// Change bits published by the updater threads
+enum ControlChange : ChangeMask {
+    TEMPERATURE_CHANGED = 1u << 0,
+    FAN_CHANGED = 1u << 1,
+    MODE_CHANGED = 1u << 2,
+};
+
 // Forward declarations
 class HVACControl;
 class ClimateControlManager;
@@ -28,15 +53,18 @@ protected:
     int controlId;
     string controlName;
     mutable int logCount;  // Mutable for logging in const methods
+    Xoshiro256pp randomStream;  // Own stream keyed by control id; HVAC_SEED makes runs repeatable
     
 public:
     HVACControl(const std::string& name) 
-        : controlId(++idCounter), controlName(name), logCount(0) {}
+        : controlId(++idCounter), controlName(name), logCount(0),
+          randomStream(Xoshiro256pp::forStream(Xoshiro256pp::processSeed(), static_cast<uint64_t>(controlId))) {}
     
     virtual ~HVACControl() = default;
     
     // Pure virtual functions for polymorphism
-    virtual void render() const = 0;
+    virtual void render(ostream& out) const = 0;
+    void render() const { render(cout); }
     virtual void updateSettings() = 0;
     
     // Getter for control name
@@ -46,6 +74,9 @@ public:
     }
     
     int getId() const { return controlId; }
+    
+    // Noise for this control's updater; only that updater draws from it.
+    Xoshiro256pp& random() { return randomStream; }
 };
 
 // Static member definition
@@ -65,9 +96,9 @@ private:
 public:
     TemperatureControlScreen() : HVACControl("TemperatureControl"), temperature(22) {}
     
-    void render() const override {
+    void render(ostream& out) const override {
         lock_guard<mutex> lock(tempMutex);
-        cout << "[TemperatureControlScreen] Temp: " << temperature << "°C" << endl;
+        out << "[TemperatureControlScreen] Temp: " << temperature << "°C" << '\n';
     }
     
     void updateSettings() override {
@@ -82,6 +113,7 @@ public:
     // Setters and getters with validation
     void setTemperature(int temp) {
         lock_guard<mutex> lock(tempMutex);
+        recordInput(InputKind::Temperature, temp);
         if (temp >= MIN_TEMP && temp <= MAX_TEMP) {
             temperature = temp;
         }
@@ -104,9 +136,9 @@ private:
 public:
     FanSpeedControlScreen() : HVACControl("FanSpeedControl"), fanLevel(1) {}
     
-    void render() const override {
+    void render(ostream& out) const override {
         lock_guard<mutex> lock(fanMutex);
-        cout << "[FanSpeedControlScreen] Fan: Level " << fanLevel << endl;
+        out << "[FanSpeedControlScreen] Fan: Level " << fanLevel << '\n';
     }
     
     void updateSettings() override {
@@ -116,6 +148,7 @@ public:
     
     void setFanLevel(int level) {
         lock_guard<mutex> lock(fanMutex);
+        recordInput(InputKind::FanLevel, level);
         if (level >= 0 && level <= fanLimit) {  // Using extern variable
             fanLevel = level;
         }
@@ -149,9 +182,9 @@ private:
 public:
     ModeControlScreen() : HVACControl("ModeControl"), currentMode(Mode::AC) {}
     
-    void render() const override {
+    void render(ostream& out) const override {
         lock_guard<mutex> lock(modeMutex);
-        cout << "[ModeControlScreen] Mode: " << modeToString(currentMode) << endl;
+        out << "[ModeControlScreen] Mode: " << modeToString(currentMode) << '\n';
     }
     
     void updateSettings() override {
@@ -164,6 +197,7 @@ public:
     
     void setMode(int mode) {
         lock_guard<mutex> lock(modeMutex);
+        recordInput(InputKind::Mode, mode);
         if (mode >= 0 && mode <= 2) {
             currentMode = static_cast<Mode>(mode);
         }
@@ -178,160 +212,277 @@ public:
 // Climate Control Manager
 class ClimateControlManager {
 private:
-    vector<shared_ptr<HVACControl>> controls;  // Smart pointers in STL container
-    mutex managerMutex;
-    condition_variable renderCondition;
+    using Registry = ControlRegistry<HVACControl>;  // Smart pointers indexed by name and type
+    EpochProtected<Registry> controls;  // Readers take no lock; add/remove copy-on-write
+    mutex renderMutex;  // Serializes frames only; never taken by add/remove
+    ChangeBus changes;  // Updaters publish here; renderers and others subscribe
+    ChangeBus::Subscription renderChanges = changes.subscribe();
     atomic<bool> keepRunning{true};
+    unique_ptr<WorkStealingPool> updatePool;  // Built by the first updateAllSettings(), not per manager
+    once_flag updatePoolOnce;
+    static const size_t UPDATE_CHUNK = 64;  // Controls per stealable task
+    FrameCompositor frame;  // Reused screen buffer; HVAC_HEADLESS=1 skips the terminal
     
 public:
-    void addControl(shared_ptr<HVACControl> control) {
-        lock_guard<mutex> lock(managerMutex);
-        controls.push_back(control);
+    // Registered under the static type T, which the typed getters look up.
+    template <typename T>
+    void addControl(shared_ptr<T> control) {
+        const string name = control->getName();
+        controls.update([&](Registry& registry) { registry.add(move(control), name); });
     }
     
     void removeControl(const string& controlName) {
-        lock_guard<mutex> lock(managerMutex);
-        // Using auto storage class for iteration
-        auto it = remove_if(controls.begin(), controls.end(),
-            [&controlName](const shared_ptr<HVACControl>& control) {
-                return control->getName() == controlName;
-            });
-        controls.erase(it, controls.end());
+        // One interned-id lookup, no string compares; a frame in progress keeps its snapshot
+        controls.update([&](Registry& registry) { registry.remove(controlName); });
     }
     
     void renderAll() {
-        lock_guard<mutex> lock(managerMutex);
+        lock_guard<mutex> lock(renderMutex);
+        auto snapshot = controls.read();  // Pinned; slow output never stalls add/remove
         register int counter = 0;  // Register storage class (deprecated but for demonstration)
         
-        // Clear screen (simple console clear)
-        cout << "\033[2J\033[1;1H";
+        // Compose the screen in memory; present() rewrites only changed cells
+        ostream& out = frame.begin();
         
-        for (const auto& control : controls) {  // Auto storage class
-            control->render();
+        for (const auto& control : snapshot->controls()) {  // Auto storage class
+            control->render(out);
             ++counter;
         }
-        cout << endl;
+        frame.present();
     }
     
+    // Each control locks only its own mutex, so chunks update in parallel.
+    // parallelFor() joins every chunk before returning, ahead of the next render.
     void updateAllSettings() {
-        lock_guard<mutex> lock(managerMutex);
-        for (auto& control : controls) {
-            control->updateSettings();
-        }
+        call_once(updatePoolOnce, [this] { updatePool = make_unique<WorkStealingPool>(); });
+        auto snapshot = controls.read();
+        const auto& list = snapshot->controls();
+        updatePool->parallelFor(list.size(), UPDATE_CHUNK, [&list](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                list[i]->updateSettings();
+            }
+        });
     }
     
     void stop() {
         keepRunning = false;
-        renderCondition.notify_all();
+        changes.close();
     }
     
     bool isRunning() const {
         return keepRunning;
     }
     
-    void waitForUpdate() {
-        unique_lock<mutex> lock(managerMutex);
-        renderCondition.wait_for(lock, chrono::milliseconds(500));
+    // Sleeps until something changes (at most 500 ms). Bursts of updates
+    // come back as one combined mask; the manager lock is not held meanwhile.
+    ChangeMask waitForUpdate() {
+        return renderChanges.waitFor(chrono::milliseconds(500));
+    }
+    
+    // Wakes the renderer only if it is waiting and nothing was pending yet.
+    void notifyUpdate(ChangeMask changed) {
+        changes.publish(changed);
     }
     
-    void notifyUpdate() {
-        renderCondition.notify_one();
+    // Extra consumers (loggers, exporters) get their own coalesced stream.
+    ChangeBus::Subscription subscribe(ChangeMask interest = ChangeBus::kAll) {
+        return changes.subscribe(interest);
     }
     
-    // Get specific controls for thread operations
+    // Get specific controls for thread operations: O(1) typed lookups,
+    // no linear dynamic_pointer_cast scan on every updater iteration
     shared_ptr<TemperatureControlScreen> getTemperatureControl() {
-        lock_guard<mutex> lock(managerMutex);
-        for (auto& control : controls) {
-            auto tempControl = dynamic_pointer_cast<TemperatureControlScreen>(control);
-            if (tempControl) {
-                return tempControl;
-            }
-        }
-        return nullptr;
+        return controls.read()->get<TemperatureControlScreen>();
     }
     
     shared_ptr<FanSpeedControlScreen> getFanControl() {
-        lock_guard<std::mutex> lock(managerMutex);
-        for (auto& control : controls) {
-            auto fanControl = dynamic_pointer_cast<FanSpeedControlScreen>(control);
-            if (fanControl) {
-                return fanControl;
-            }
-        }
-        return nullptr;
+        return controls.read()->get<FanSpeedControlScreen>();
     }
     
     shared_ptr<ModeControlScreen> getModeControl() {
-        lock_guard<mutex> lock(managerMutex);
-        for (auto& control : controls) {
-            auto modeControl = dynamic_pointer_cast<ModeControlScreen>(control);
-            if (modeControl) {
-                return modeControl;
-            }
-        }
-        return nullptr;
+        return controls.read()->get<ModeControlScreen>();
     }
 };
 
+// One temperature update step, drawn from the control's own stream
+void updateTemperature(ClimateControlManager& manager) {
+    auto tempControl = manager.getTemperatureControl();
+    if (tempControl) {
+        int newTemp = tempControl->random().range(18, 28);
+        tempControl->setTemperature(newTemp);
+        manager.notifyUpdate(TEMPERATURE_CHANGED);
+    }
+}
+
+// One fan and mode update step; each control draws from its own stream
+void updateFanAndMode(ClimateControlManager& manager) {
+    auto fanControl = manager.getFanControl();
+    auto modeControl = manager.getModeControl();
+    
+    if (fanControl && modeControl) {
+        // No outer scoped_lock here: each setter locks its own mutex, and
+        // holding fanMutex across setFanLevel() re-locked it and deadlocked
+        int newFanLevel = fanControl->random().range(1, fanLimit);
+        int newMode = modeControl->random().range(0, 2);
+        
+        fanControl->setFanLevel(newFanLevel);
+        modeControl->setMode(newMode);
+        
+        manager.notifyUpdate(FAN_CHANGED | MODE_CHANGED);
+    }
+}
+
+#if HVAC_HAS_COROUTINES
+// C++20: both updaters are coroutines sharing one event-loop thread, each
+// costing a small frame instead of a thread stack
+Task temperatureUpdateTask(ClimateControlManager& manager) {
+    PeriodicSchedule schedule("temperatureUpdateTask", chrono::milliseconds(1000));
+    while (manager.isRunning()) {
+        updateTemperature(manager);
+        co_await sleepUntil(schedule.deadline());
+        schedule.onWake();
+    }
+}
+
+Task fanModeUpdateTask(ClimateControlManager& manager) {
+    PeriodicSchedule schedule("fanModeUpdateTask", chrono::milliseconds(1500));
+    while (manager.isRunning()) {
+        updateFanAndMode(manager);
+        co_await sleepUntil(schedule.deadline());
+        schedule.onWake();
+    }
+}
+#else
 // Thread function for temperature updates
 void temperatureUpdateThread(ClimateControlManager& manager) {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> tempDist(18, 28);
+    applyThreadPlacement(ThreadRole::Control, cerr);
+    PeriodicTimer timer("temperatureUpdateThread", chrono::milliseconds(1000));  // Fixed grid, no drift
     
     while (manager.isRunning()) {
-        auto tempControl = manager.getTemperatureControl();
-        if (tempControl) {
-            int newTemp = tempDist(gen);
-            tempControl->setTemperature(newTemp);
-            tempControl->updateSettings();
-            manager.notifyUpdate();
-        }
-        this_thread::sleep_for(chrono::milliseconds(1000));
+        updateTemperature(manager);
+        timer.wait();
     }
 }
 
 // Thread function for fan and mode updates
 void fanModeUpdateThread(ClimateControlManager& manager) {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> fanDist(1, fanLimit);
-    uniform_int_distribution<> modeDist(0, 2);
+    applyThreadPlacement(ThreadRole::Control, cerr);
+    PeriodicTimer timer("fanModeUpdateThread", chrono::milliseconds(1500));
     
     while (manager.isRunning()) {
-        auto fanControl = manager.getFanControl();
-        auto modeControl = manager.getModeControl();
-        
-        if (fanControl && modeControl) {
-            // Demonstrate potential deadlock scenario and fix
-            // Using scoped_lock to prevent deadlock by locking both mutexes atomically
-            scoped_lock lock(fanControl->getFanMutex(), 
-                                 manager.getTemperatureControl()->getTempMutex());
-            
-            int newFanLevel = fanDist(gen);
-            int newMode = modeDist(gen);
-            
-            fanControl->setFanLevel(newFanLevel);
-            modeControl->setMode(newMode);
-            
-            fanControl->updateSettings();
-            modeControl->updateSettings();
-            
-            manager.notifyUpdate();
-        }
-        this_thread::sleep_for(chrono::milliseconds(1500));
+        updateFanAndMode(manager);
+        timer.wait();
     }
 }
+#endif
 
-// Main rendering thread
+// Main rendering thread. Each frame first runs one updateSettings() pass
+// over every control (histories), joined before the frame is composed.
 void renderThread(ClimateControlManager& manager) {
+    applyThreadPlacement(ThreadRole::Render, cerr);
     while (manager.isRunning()) {
+        manager.updateAllSettings();
         manager.renderAll();
         manager.waitForUpdate();
     }
 }
 
-int main() {
+// Feeds a recorded trace through the setters instead of the random updaters.
+// speed 0 replays as fast as possible without rendering.
+int replayMain(const string& path, double speed) {
+    InputTrace trace = InputTrace::load(path);
+    ClimateControlManager manager;
+    auto tempControl = make_shared<TemperatureControlScreen>();
+    auto fanControl = make_shared<FanSpeedControlScreen>();
+    auto modeControl = make_shared<ModeControlScreen>();
+    manager.addControl(tempControl);
+    manager.addControl(fanControl);
+    manager.addControl(modeControl);
+    
+    thread displayThread;
+    if (speed > 0) {
+        displayThread = thread(renderThread, ref(manager));
+    }
+    ReplayStats stats = replayTrace(trace, speed, [&](const InputEvent& event) {
+        switch (event.kind) {
+            case InputKind::Temperature:
+                tempControl->setTemperature(event.value);
+                manager.notifyUpdate(TEMPERATURE_CHANGED);
+                break;
+            case InputKind::FanLevel:
+                fanControl->setFanLevel(event.value);
+                manager.notifyUpdate(FAN_CHANGED);
+                break;
+            case InputKind::Mode:
+                modeControl->setMode(event.value);
+                manager.notifyUpdate(MODE_CHANGED);
+                break;
+        }
+    });
+    manager.stop();
+    if (displayThread.joinable()) {
+        displayThread.join();
+    }
+    
+    cout << "Replayed " << stats.events << " inputs in "
+         << chrono::duration<double, milli>(stats.elapsed).count() << " ms. Final: "
+         << tempControl->getTemperature() << "°C, fan " << fanControl->getFanLevel()
+         << ", " << modeControl->getCurrentMode() << endl;
+    return 0;
+}
+
+#ifdef HVAC_BENCH
+// Bench entry point (see hvac_bench.h), built in place of main().
+// updateAllSettings runs over a separate fleet large enough to split into
+// chunks, so its latency includes the pool's join.
+Variant makeBenchVariant() {
+    static const int BENCH_FLEET = 1024;
+    struct State {
+        ClimateControlManager manager;
+        ClimateControlManager fleet;
+        shared_ptr<TemperatureControlScreen> temp = make_shared<TemperatureControlScreen>();
+        shared_ptr<FanSpeedControlScreen> fan = make_shared<FanSpeedControlScreen>();
+        shared_ptr<ModeControlScreen> mode = make_shared<ModeControlScreen>();
+        State() {
+            manager.addControl(temp);
+            manager.addControl(fan);
+            manager.addControl(mode);
+            for (int i = 0; i < BENCH_FLEET; ++i) {
+                fleet.addControl(make_shared<TemperatureControlScreen>());
+            }
+        }
+    };
+    auto s = make_shared<State>();
+    State* p = s.get();
+    return Variant{"today4",
+                   {{"setTemperature", OpKind::Write, [p](unsigned v) { p->temp->setTemperature(16 + static_cast<int>(v % 15)); }},
+                    {"getTemperature", OpKind::Read, [p](unsigned) { (void)p->temp->getTemperature(); }},
+                    {"setFanLevel", OpKind::Write, [p](unsigned v) { p->fan->setFanLevel(static_cast<int>(v % 6)); }},
+                    {"getFanLevel", OpKind::Read, [p](unsigned) { (void)p->fan->getFanLevel(); }},
+                    {"setMode", OpKind::Write, [p](unsigned v) { p->mode->setMode(static_cast<int>(v % 3)); }},
+                    {"getMode", OpKind::Read, [p](unsigned) { (void)p->mode->getCurrentMode(); }},
+                    {"renderAll", OpKind::Render, [p](unsigned) { p->manager.renderAll(); }},
+                    {"updateAllSettings", OpKind::Render, [p](unsigned) { p->fleet.updateAllSettings(); }}},
+                   s};
+}
+#else
+int main(int argc, char* argv[]) {
+    // --replay FILE [speed|max] reruns a trace; a trailing --record FILE traces this run.
+    // HVAC_PLACEMENT pins and prioritizes the threads (see hvac_thread_placement.h).
+    try {
+        PlacementConfig::current() = PlacementConfig::fromEnvironment();
+        applyMemoryLock(cerr);
+        if (argc >= 3 && string(argv[1]) == "--replay") {
+            return replayMain(argv[2], argc >= 4 ? parseReplaySpeed(argv[3]) : 1.0);
+        }
+        if (argc >= 3 && string(argv[argc - 2]) == "--record") {
+            inputRecorder = make_unique<InputRecorder>(argv[argc - 1], Xoshiro256pp::processSeed());
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    
     // Create Climate Control Manager
     ClimateControlManager manager;
     
@@ -355,8 +506,18 @@ int main() {
     this_thread::sleep_for(chrono::milliseconds(2000));
     
     // Start threads
+#if HVAC_HAS_COROUTINES
+    EventLoop updateLoop;
+    updateLoop.spawn(temperatureUpdateTask(manager));
+    updateLoop.spawn(fanModeUpdateTask(manager));
+    thread updateThread([&updateLoop] {
+        applyThreadPlacement(ThreadRole::Control, cerr);
+        updateLoop.run();
+    });
+#else
     thread tempThread(temperatureUpdateThread, ref(manager));
     thread fanModeThread(fanModeUpdateThread, ref(manager));
+#endif
     thread displayThread(renderThread, ref(manager));
     
     // Run simulation for 10 seconds
@@ -367,17 +528,28 @@ int main() {
     manager.stop();
     
     // Join threads safely
+#if HVAC_HAS_COROUTINES
+    updateLoop.stop();  // Don't wait out the 1.5 s sleep
+    updateThread.join();
+#else
     if (tempThread.joinable()) {
         tempThread.join();
     }
     if (fanModeThread.joinable()) {
         fanModeThread.join();
     }
+#endif
     if (displayThread.joinable()) { 
         displayThread.join();
     }
     
+    if (inputRecorder) {
+        cout << "Recorded " << inputRecorder->recorded() << " inputs to " << inputRecorder->path() << endl;
+        inputRecorder.reset();  // Flush before exit
+    }
+    LoopStats::reportAll(cout);
     cout << "Simulation completed successfully!" << endl;
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // HVAC_BENCH
@@ -4,76 +4,321 @@
 #include <memory> // For smart pointers
 #include <thread>
 #include <mutex>
-#include <condition_variable>
 #include <atomic>
-#include <random>
 #include <chrono> // For std::chrono::milliseconds
-#include <deque>  // For temperature history
-#include <list>   // For mode history
 #include <algorithm> // For std::find_if
+#include "hvac_seqlock.h" // Lock-free published HVAC state
+#include "hvac_ring_buffer.h" // Fixed-capacity temperature/mode history
+#include "hvac_zone_store.h" // Struct-of-arrays backend for many zones
+#include "hvac_timer_wheel.h" // Shared scheduler for periodic updaters
+#include "hvac_control_registry.h" // O(1) control lookup by name and type
+#include "hvac_profiled_mutex.h" // Contention stats with -DHVAC_PROFILE_LOCKS
+#include "hvac_thermal_model.h" // Batched PID thermal model
+#include "hvac_sim_clock.h" // Virtual-time deterministic simulation
+#include "hvac_telemetry_log.h" // Memory-mapped full-resolution change log
+#include "hvac_change_bus.h" // Coalesced change notifications with a field mask
+#include "hvac_epoch.h" // Lock-free published control list
+#include "hvac_random.h" // Seedable xoshiro256++ streams with batch fill
+#include "hvac_coroutine.h" // Event-loop behaviors in C++20 builds (HVAC_HAS_COROUTINES)
+#include "hvac_shared_state.h" // HVAC state mirrored into POSIX shared memory
+#include "hvac_input_trace.h" // Binary record/replay of setter calls
+#include "hvac_periodic.h" // Deadline-grid loops with miss counts and jitter histograms
+#include "hvac_thread_placement.h" // CPU pinning, SCHED_FIFO and mlockall per thread role
+#include "hvac_shard_runtime.h" // Shard-per-core fleets with SPSC message queues
+#include "hvac_control_server.h" // Epoll server for the binary control protocol
+#include "hvac_rolling_stats.h" // O(1) min/max/mean/stddev over trailing windows
+#include "hvac_snapshot.h" // Versioned, atomically written, mmap-loaded manager snapshots
+#include "hvac_bench.h" // makeBenchVariant() for -DHVAC_BENCH builds
+#include "hvac_frame_writer.h" // Diffed full-screen frames in one write(2)
 
 // fanLimit is now directly defined here, no 'extern' needed for a single file.
 int fanLimit = 5; 
 
-// Mutexes for protecting shared resources
-std::mutex g_temperatureMutex;
-std::mutex g_fanSpeedMutex;
-std::mutex g_modeMutex;
-std::mutex g_consoleMutex; // For safe console output
+// Mutexes for protecting shared resources (plain std::mutex unless built
+// with -DHVAC_PROFILE_LOCKS, which reports contention per lock at exit)
+ProfiledMutex g_temperatureMutex("g_temperatureMutex");
+ProfiledMutex g_fanSpeedMutex("g_fanSpeedMutex");
+ProfiledMutex g_modeMutex("g_modeMutex");
+ProfiledMutex g_consoleMutex("g_consoleMutex"); // For safe console output
 
-// Condition variable to signal re-render
-std::condition_variable g_renderCondition;
+// Field-level change events. Controls publish what changed; the renderer
+// (and any other subscriber) wakes once per burst with the combined mask.
+enum HVACChange : ChangeMask {
+    kTemperatureChanged = 1u << 0,
+    kFanLevelChanged = 1u << 1,
+    kModeChanged = 1u << 2,
+    kControlsChanged = 1u << 3, // A control was added or removed
+};
+
+ChangeBus g_changeBus;
 
 // Atomic flag for graceful shutdown
 std::atomic<bool> g_keepRunning(true);
 
+// Process-wide view of the climate: the values most recently published by
+// any temperature, fan and mode control. Each control's own getters read
+// the control's own SeqLock instead; this aggregate only feeds --publish,
+// --serve responses and other whole-system readers.
+struct HVACState {
+    int temperature;
+    int fanLevel;
+    int mode;
+};
+
+SeqLock<HVACState> g_hvacState(HVACState{20, 1, 0});
+
+// Out-of-process mirror of g_hvacState, opened with --publish NAME. Another
+// process attaches with --watch NAME and reads it at its own rate.
+std::unique_ptr<SharedStatePublisher<HVACState>> g_sharedState;
+
+// Applies the same field update to the aggregate and its shared-memory mirror.
+template <typename Fn>
+void publishState(Fn fn) {
+    g_hvacState.update(fn);
+    if (g_sharedState) {
+        g_sharedState->update(fn);
+    }
+}
+
+// Full-resolution change log, opened with --log DIR. Setters append while
+// holding their control's mutex; an append takes the log's own mutex and
+// writes into mapped memory. Log failures are reported, never thrown.
+std::unique_ptr<TelemetryLogWriter> g_telemetryLog;
+const SimClock* g_telemetryClock = nullptr; // Set by --simulate; wall clock otherwise
+
+void logTelemetry(TelemetryKind kind, int value) {
+    if (!g_telemetryLog) {
+        return;
+    }
+    std::int64_t now = g_telemetryClock != nullptr
+        ? g_telemetryClock->now().time_since_epoch().count()
+        : std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::system_clock::now().time_since_epoch()).count();
+    g_telemetryLog->append(kind, value, now);
+}
+
+// Input trace, opened with --record FILE. Setters record the requested value
+// (before validation), so --replay FILE reproduces the run's inputs exactly.
+std::unique_ptr<InputRecorder> g_inputRecorder;
+
+void recordInput(InputKind kind, int value) {
+    if (!g_inputRecorder) {
+        return;
+    }
+    if (g_telemetryClock != nullptr) {
+        g_inputRecorder->record(kind, value, g_telemetryClock->now().time_since_epoch().count());
+    } else {
+        g_inputRecorder->record(kind, value);
+    }
+}
+
+// Sample time for rolling statistics: virtual under --simulate, so the
+// windows span simulated minutes and hours; steady time otherwise.
+std::chrono::nanoseconds statsTimestamp() {
+    return g_telemetryClock != nullptr
+        ? std::chrono::duration_cast<std::chrono::nanoseconds>(g_telemetryClock->now().time_since_epoch())
+        : std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now().time_since_epoch());
+}
+
+// Windows the control screens keep statistics over.
+RollingStats defaultStatWindows() {
+    return RollingStats{std::chrono::minutes(1), std::chrono::minutes(10), std::chrono::hours(1)};
+}
+
+void writeRollingSummaries(std::ostream& out, const RollingStats::Summaries& summaries, std::size_t windows) {
+    for (std::size_t i = 0; i < windows; ++i) {
+        out << (i == 0 ? "  " : " | ");
+        writeRollingSummary(out, summaries[i]);
+    }
+    out << "\n";
+}
+
+// Rolling-statistics samples in a snapshot are stored by age, not by
+// timestamp, so they line up with whatever clock the restoring run uses
+// (steady time, or a virtual clock that starts again at zero).
+struct StatsSample {
+    std::int64_t ageNs;
+    double value;
+};
+constexpr std::uint32_t kStatsSnapshotVersion = 1;
+
+void saveRollingStats(SnapshotWriter& writer, const std::string& section, const RollingStats& stats) {
+    std::chrono::nanoseconds now = statsTimestamp();
+    std::vector<StatsSample> samples;
+    stats.forEachSample([&](std::chrono::nanoseconds time, double value) {
+        samples.push_back(StatsSample{(now - time).count(), value});
+    });
+    writer.addArray(section, kStatsSnapshotVersion, samples.data(), samples.size());
+}
+
+// Replaces stats with the saved samples, or leaves it empty if there are none.
+void restoreRollingStats(const SnapshotReader& reader, const std::string& section, RollingStats& stats) {
+    std::chrono::nanoseconds now = statsTimestamp();
+    stats.clear();
+    for (const StatsSample& sample : reader.findArray<StatsSample>(section, kStatsSnapshotVersion)) {
+        stats.add(now - std::chrono::nanoseconds(sample.ageNs), sample.value);
+    }
+}
+
 // Abstract Base Class
 class HVACControl {
 public:
-    virtual void render() const = 0;
+    virtual void render(std::ostream& out) const = 0;
+    void render() const { render(std::cout); }
     virtual void updateSettings() = 0;
     virtual std::string getName() const = 0;
 
+    // Snapshot support for ClimateControlManager. Controls save their
+    // settings and history in sections named after getName(). restore
+    // returns false, keeping the current state, if the snapshot has no
+    // section of the expected version for this control.
+    virtual void saveSnapshot(SnapshotWriter& /*writer*/) const {}
+    virtual bool restoreSnapshot(const SnapshotReader& /*reader*/) { return false; }
+
+    // Assigned in construction order, starting at 1; keys per-control random streams.
+    int getId() const {
+        return m_id;
+    }
+
+    // Returns true if the control changed since the last call and clears the flag.
+    bool consumeDirty() {
+        return m_dirty.exchange(false, std::memory_order_acq_rel);
+    }
+
 protected:
     // Static member for assigning unique IDs
     static int s_idCounter; // Declared, defined below
+    int m_id = 0; // Set from s_idCounter by each derived constructor
+
+    // Called by setters whenever displayed state actually changes.
+    void markDirty(HVACChange change) {
+        m_dirty.store(true, std::memory_order_release);
+        g_changeBus.publish(change);
+    }
+
+private:
+    std::atomic<bool> m_dirty{true}; // New controls are drawn on the next frame
 };
 
 int HVACControl::s_idCounter = 0; // Definition of static member
 
 // Derived Class: TemperatureControlScreen
 class TemperatureControlScreen : public HVACControl {
+public:
+    static constexpr std::size_t kHistorySize = 10; // Keep last 10 temperatures
+    using History = SpscRingBuffer<int, kHistorySize>;
+
 private:
     int m_temperature;
-    std::deque<int> m_temperatureHistory;
+    History m_temperatureHistory; // Written under g_temperatureMutex only
+    RollingStats m_temperatureStats; // Written under g_temperatureMutex only
+    SeqLock<RollingStats::Summaries> m_publishedStats; // Lock-free copy for render() and exporters
+    SeqLock<int> m_publishedTemperature; // Lock-free copy for getTemperature()
     mutable int m_logCount; // mutable to allow modification in const methods
 
+    // Caller holds g_temperatureMutex (or is the constructor).
+    void publishTemperature(int temp) {
+        m_publishedTemperature.store(temp);
+        publishState([temp](HVACState& state) { state.temperature = temp; });
+    }
+
+    // Caller holds g_temperatureMutex. Every accepted request is a sample,
+    // including repeats, so the windows reflect how long a value was held.
+    void sampleTemperature(int temp) {
+        m_temperatureStats.add(statsTimestamp(), temp);
+        m_publishedStats.store(m_temperatureStats.summaries());
+    }
+
 public:
-    TemperatureControlScreen(int initialTemp = 20)
-        : m_temperature(initialTemp), m_logCount(0) {
-        s_idCounter++; // Increment static ID counter
-        m_temperatureHistory.push_back(initialTemp);
+    TemperatureControlScreen(int initialTemp = 20, RollingStats statWindows = defaultStatWindows())
+        : m_temperature(initialTemp), m_temperatureStats(std::move(statWindows)), m_logCount(0) {
+        m_id = ++s_idCounter; // Increment static ID counter
+        m_temperatureHistory.push(initialTemp);
+        sampleTemperature(initialTemp);
+        publishTemperature(initialTemp);
+        logTelemetry(TelemetryKind::Temperature, initialTemp);
+    }
+
+    // The range setTemperature accepts; restored snapshots are held to it too.
+    static bool isValidTemperature(int temp) {
+        return temp >= 15 && temp <= 30;
     }
 
     void setTemperature(int temp) {
-        std::lock_guard<std::mutex> lock(g_temperatureMutex);
-        if (temp >= 15 && temp <= 30) { // Validation
+        HVAC_LOCK_SITE();
+        std::lock_guard<ProfiledMutex> lock(g_temperatureMutex);
+        recordInput(InputKind::Temperature, temp);
+        if (!isValidTemperature(temp)) { // Validation
+            return;
+        }
+        sampleTemperature(temp);
+        if (temp != m_temperature) {
             m_temperature = temp;
-            m_temperatureHistory.push_back(temp);
-            if (m_temperatureHistory.size() > 10) { // Keep last 10 temperatures
-                m_temperatureHistory.pop_front();
-            }
+            m_temperatureHistory.push(temp);
+            publishTemperature(temp);
+            logTelemetry(TelemetryKind::Temperature, temp);
+            markDirty(kTemperatureChanged);
         }
     }
 
     int getTemperature() const {
-        std::lock_guard<std::mutex> lock(g_temperatureMutex);
-        return m_temperature;
+        return m_publishedTemperature.load(); // Lock-free read of this control's published value
+    }
+
+    // Consistent copy of recent temperatures, oldest first; never blocks setTemperature.
+    History::Snapshot getTemperatureHistory() const {
+        return m_temperatureHistory.snapshot();
+    }
+
+    // Rolling temperature statistics per window, as of the last sample; never blocks setTemperature.
+    RollingStats::Summaries getTemperatureStats() const {
+        return m_publishedStats.load();
+    }
+
+    struct SnapshotState {
+        std::int32_t temperature;
+        History::Snapshot history;
+    };
+    static constexpr std::uint32_t kSnapshotVersion = 1;
+
+    void saveSnapshot(SnapshotWriter& writer) const override {
+        HVAC_LOCK_SITE();
+        std::lock_guard<ProfiledMutex> lock(g_temperatureMutex);
+        writer.add(getName(), kSnapshotVersion, SnapshotState{m_temperature, m_temperatureHistory.snapshot()});
+        saveRollingStats(writer, getName() + ".stats", m_temperatureStats);
+    }
+
+    bool restoreSnapshot(const SnapshotReader& reader) override {
+        const SnapshotState* saved = reader.find<SnapshotState>(getName(), kSnapshotVersion);
+        if (saved == nullptr || !isValidTemperature(saved->temperature) || saved->history.count > kHistorySize ||
+            !std::all_of(saved->history.begin(), saved->history.end(), isValidTemperature)) {
+            return false;
+        }
+        HVAC_LOCK_SITE();
+        std::lock_guard<ProfiledMutex> lock(g_temperatureMutex);
+        int temp = saved->temperature;
+        m_temperature = temp;
+        m_temperatureHistory.clear();
+        for (int entry : saved->history) {
+            m_temperatureHistory.push(entry);
+        }
+        restoreRollingStats(reader, getName() + ".stats", m_temperatureStats);
+        m_publishedStats.store(m_temperatureStats.summaries());
+        publishTemperature(temp);
+        logTelemetry(TelemetryKind::Temperature, temp);
+        markDirty(kTemperatureChanged);
+        return true;
+    }
+
+    std::size_t statWindowCount() const {
+        return m_temperatureStats.windowCount(); // Fixed at construction
     }
 
-    void render() const override {
-        std::lock_guard<std::mutex> lock(g_consoleMutex);
-        std::cout << "[TemperatureControlScreen] Temp: " << getTemperature() << "\u00B0C" << std::endl;
+    // Caller must hold g_consoleMutex (renderAll does).
+    void render(std::ostream& out) const override {
+        out << "[TemperatureControlScreen] Temp: " << getTemperature() << "\u00B0C\n";
+        writeRollingSummaries(out, getTemperatureStats(), statWindowCount());
         m_logCount++; // Increment mutable log counter
     }
 
@@ -91,29 +336,97 @@ public:
 class FanSpeedControlScreen : public HVACControl {
 private:
     int m_fanLevel;
+    RollingStats m_fanStats; // Written under g_fanSpeedMutex only
+    SeqLock<RollingStats::Summaries> m_publishedStats;
+
+    SeqLock<int> m_publishedFanLevel;
+
+    void publishFanLevel(int level) {
+        m_publishedFanLevel.store(level);
+        publishState([level](HVACState& state) { state.fanLevel = level; });
+    }
+
+    void sampleFanLevel(int level) {
+        m_fanStats.add(statsTimestamp(), level);
+        m_publishedStats.store(m_fanStats.summaries());
+    }
 
 public:
-    FanSpeedControlScreen(int initialLevel = 1) : m_fanLevel(initialLevel) {
-        s_idCounter++;
+    FanSpeedControlScreen(int initialLevel = 1, RollingStats statWindows = defaultStatWindows())
+        : m_fanLevel(initialLevel), m_fanStats(std::move(statWindows)) {
+        m_id = ++s_idCounter;
+        sampleFanLevel(initialLevel);
+        publishFanLevel(initialLevel);
+        logTelemetry(TelemetryKind::FanLevel, initialLevel);
+    }
+
+    static bool isValidFanLevel(int level) {
+        return level >= 0 && level <= fanLimit;
     }
 
     void setFanLevel(int level) {
         // Use std::scoped_lock for atomic locking with temperature for deadlock fix demonstration
+        HVAC_LOCK_SITE();
         std::scoped_lock lock(g_fanSpeedMutex, g_temperatureMutex); // Consistent lock ordering
+        recordInput(InputKind::FanLevel, level);
 
-        if (level >= 0 && level <= fanLimit) { // Validation using global fanLimit
+        if (!isValidFanLevel(level)) { // Validation using global fanLimit
+            return;
+        }
+        sampleFanLevel(level);
+        if (level != m_fanLevel) {
             m_fanLevel = level;
+            publishFanLevel(level);
+            logTelemetry(TelemetryKind::FanLevel, level);
+            markDirty(kFanLevelChanged);
         }
     }
 
     int getFanLevel() const {
-        std::lock_guard<std::mutex> lock(g_fanSpeedMutex);
-        return m_fanLevel;
+        return m_publishedFanLevel.load();
+    }
+
+    RollingStats::Summaries getFanLevelStats() const {
+        return m_publishedStats.load();
+    }
+
+    struct SnapshotState {
+        std::int32_t fanLevel;
+    };
+    static constexpr std::uint32_t kSnapshotVersion = 1;
+
+    void saveSnapshot(SnapshotWriter& writer) const override {
+        HVAC_LOCK_SITE();
+        std::lock_guard<ProfiledMutex> lock(g_fanSpeedMutex);
+        writer.add(getName(), kSnapshotVersion, SnapshotState{m_fanLevel});
+        saveRollingStats(writer, getName() + ".stats", m_fanStats);
+    }
+
+    bool restoreSnapshot(const SnapshotReader& reader) override {
+        const SnapshotState* saved = reader.find<SnapshotState>(getName(), kSnapshotVersion);
+        if (saved == nullptr || !isValidFanLevel(saved->fanLevel)) {
+            return false;
+        }
+        HVAC_LOCK_SITE();
+        std::lock_guard<ProfiledMutex> lock(g_fanSpeedMutex);
+        int level = saved->fanLevel;
+        m_fanLevel = level;
+        restoreRollingStats(reader, getName() + ".stats", m_fanStats);
+        m_publishedStats.store(m_fanStats.summaries());
+        publishFanLevel(level);
+        logTelemetry(TelemetryKind::FanLevel, level);
+        markDirty(kFanLevelChanged);
+        return true;
     }
 
-    void render() const override {
-        std::lock_guard<std::mutex> lock(g_consoleMutex);
-        std::cout << "[FanSpeedControlScreen] Fan: Level " << getFanLevel() << std::endl;
+    std::size_t statWindowCount() const {
+        return m_fanStats.windowCount();
+    }
+
+    // Caller must hold g_consoleMutex (renderAll does).
+    void render(std::ostream& out) const override {
+        out << "[FanSpeedControlScreen] Fan: Level " << getFanLevel() << "\n";
+        writeRollingSummaries(out, getFanLevelStats(), statWindowCount());
     }
 
     void updateSettings() override {
@@ -129,28 +442,90 @@ public:
 class ModeControlScreen : public HVACControl {
 public:
     enum Mode { AC, Heater, Auto };
+    static constexpr std::size_t kHistorySize = 5; // Keep last 5 mode changes
+    using History = SpscRingBuffer<Mode, kHistorySize>;
 private:
     Mode m_currentMode;
-    std::list<std::string> m_modeHistory;
+    History m_modeHistory; // Written under g_modeMutex only
+    SeqLock<Mode> m_publishedMode;
+
+    void publishMode(Mode mode) {
+        m_publishedMode.store(mode);
+        publishState([mode](HVACState& state) { state.mode = mode; });
+    }
 
 public:
     ModeControlScreen(Mode initialMode = AC) : m_currentMode(initialMode) {
-        s_idCounter++;
-        m_modeHistory.push_back(modeToString(initialMode));
+        m_id = ++s_idCounter;
+        m_modeHistory.push(initialMode);
+        publishMode(initialMode);
+        logTelemetry(TelemetryKind::Mode, initialMode);
+    }
+
+    // For raw values from outside (replayed traces, remote requests, snapshots).
+    static bool isValidMode(int value) {
+        return value >= AC && value <= Auto;
     }
 
     void setMode(Mode mode) {
-        std::lock_guard<std::mutex> lock(g_modeMutex);
-        m_currentMode = mode;
-        m_modeHistory.push_back(modeToString(mode));
-        if (m_modeHistory.size() > 5) { // Keep last 5 mode changes
-            m_modeHistory.pop_front();
+        HVAC_LOCK_SITE();
+        std::lock_guard<ProfiledMutex> lock(g_modeMutex);
+        recordInput(InputKind::Mode, mode);
+        if (mode == m_currentMode) {
+            return; // Nothing to record or redraw
         }
+        m_currentMode = mode;
+        m_modeHistory.push(mode);
+        publishMode(mode);
+        logTelemetry(TelemetryKind::Mode, mode);
+        markDirty(kModeChanged);
     }
 
     Mode getMode() const {
-        std::lock_guard<std::mutex> lock(g_modeMutex);
-        return m_currentMode;
+        return m_publishedMode.load();
+    }
+
+    // Consistent copy of recent modes, oldest first; never blocks setMode.
+    History::Snapshot getModeHistory() const {
+        return m_modeHistory.snapshot();
+    }
+
+    // Plain integers, so a file holding an unknown mode is rejected before
+    // anything is read as a Mode.
+    struct SnapshotState {
+        std::int32_t mode;
+        std::array<std::int32_t, kHistorySize> history; // Oldest first
+        std::uint64_t historyCount;
+    };
+    static constexpr std::uint32_t kSnapshotVersion = 1;
+
+    void saveSnapshot(SnapshotWriter& writer) const override {
+        HVAC_LOCK_SITE();
+        std::lock_guard<ProfiledMutex> lock(g_modeMutex);
+        History::Snapshot history = m_modeHistory.snapshot();
+        SnapshotState state{m_currentMode, {}, history.size()};
+        std::copy(history.begin(), history.end(), state.history.begin());
+        writer.add(getName(), kSnapshotVersion, state);
+    }
+
+    bool restoreSnapshot(const SnapshotReader& reader) override {
+        const SnapshotState* saved = reader.find<SnapshotState>(getName(), kSnapshotVersion);
+        if (saved == nullptr || !isValidMode(saved->mode) || saved->historyCount > kHistorySize ||
+            !std::all_of(saved->history.begin(), saved->history.begin() + saved->historyCount, isValidMode)) {
+            return false;
+        }
+        HVAC_LOCK_SITE();
+        std::lock_guard<ProfiledMutex> lock(g_modeMutex);
+        Mode mode = static_cast<Mode>(saved->mode);
+        m_currentMode = mode;
+        m_modeHistory.clear();
+        for (std::size_t i = 0; i < saved->historyCount; ++i) {
+            m_modeHistory.push(static_cast<Mode>(saved->history[i]));
+        }
+        publishMode(mode);
+        logTelemetry(TelemetryKind::Mode, mode);
+        markDirty(kModeChanged);
+        return true;
     }
 
     std::string modeToString(Mode mode) const {
@@ -162,9 +537,9 @@ public:
         }
     }
 
-    void render() const override {
-        std::lock_guard<std::mutex> lock(g_consoleMutex);
-        std::cout << "[ModeControlScreen] Mode: " << modeToString(getMode()) << std::endl;
+    // Caller must hold g_consoleMutex (renderAll does).
+    void render(std::ostream& out) const override {
+        out << "[ModeControlScreen] Mode: " << modeToString(getMode()) << "\n";
     }
 
     void updateSettings() override {
@@ -179,89 +554,923 @@ public:
 // HVAC Manager Module
 class ClimateControlManager {
 private:
-    std::vector<std::shared_ptr<HVACControl>> m_controls;
-    std::mutex m_managerMutex; // Mutex for managing the controls vector
+    using Registry = ControlRegistry<HVACControl>; // Indexed by interned name and by type
+    // Immutable published snapshot: readers (render, lookups) take no lock,
+    // add/remove copy it and retire the old version through the epoch domain.
+    EpochProtected<Registry> m_controls;
+    ChangeBus::Subscription m_renderChanges = g_changeBus.subscribe(); // Every field redraws
+    FrameCompositor m_frame; // Reused screen buffer; HVAC_HEADLESS=1 skips the terminal
 
 public:
-    // This member is made public temporarily for main to access shared_ptr,
-    // in a real application, proper getter methods would be used.
-    std::vector<std::shared_ptr<HVACControl>>& getControls() {
-        return m_controls;
+    // Stays valid and unchanged while held, even across add/removeControl.
+    EpochProtected<Registry>::ReadView getControls() const {
+        return m_controls.read();
+    }
+
+    // Registered under the static type T, which getControl<T>() looks up.
+    template <typename T>
+    void addControl(std::shared_ptr<T> control) {
+        std::string name = control->getName(); // Interned once, not compared per lookup
+        m_controls.update([&](Registry& controls) { controls.add(std::move(control), name); });
+        g_changeBus.publish(kControlsChanged); // New controls start dirty
     }
 
-    void addControl(std::shared_ptr<HVACControl> control) {
-        std::lock_guard<std::mutex> lock(m_managerMutex);
-        m_controls.push_back(control);
+    template <typename T>
+    void addControl(std::unique_ptr<T> control) {
+        addControl(std::shared_ptr<T>(std::move(control)));
     }
 
+    // Never waits for a frame in progress; that frame keeps drawing the
+    // snapshot it started with.
     void removeControl(const std::string& controlName) {
-        std::lock_guard<std::mutex> lock(m_managerMutex);
-        m_controls.erase(
-            std::remove_if(m_controls.begin(), m_controls.end(),
-                           [&](const std::shared_ptr<HVACControl>& control) {
-                               return control->getName() == controlName;
-                           }),
-            m_controls.end());
+        m_controls.update([&](Registry& controls) { controls.remove(controlName); });
+        g_changeBus.publish(kControlsChanged);
+    }
+
+    // O(1) typed access without dynamic_pointer_cast.
+    template <typename T>
+    std::shared_ptr<T> getControl() const {
+        return m_controls.read()->get<T>();
+    }
+
+    // Writes every control's settings and history to one snapshot file,
+    // replacing path atomically. Throws std::runtime_error on I/O failure.
+    void saveSnapshot(const std::string& path) const {
+        SnapshotWriter writer;
+        auto controls = m_controls.read();
+        for (auto const& control : controls->controls()) {
+            control->saveSnapshot(writer);
+        }
+        writer.commit(path);
+    }
+
+    // Loads state saved by saveSnapshot() into the registered controls;
+    // controls the snapshot has nothing for keep theirs. Call before the
+    // update and render loops start, since history rings are reset.
+    // Returns the number of controls restored; throws std::runtime_error if
+    // the file is missing or corrupt.
+    int restoreSnapshot(const std::string& path) {
+        SnapshotReader reader(path);
+        auto controls = m_controls.read();
+        int restored = 0;
+        for (auto const& control : controls->controls()) {
+            if (control->restoreSnapshot(reader)) {
+                ++restored;
+            }
+        }
+        return restored;
+    }
+
+    // Blocks until a change is published (or the bus closes for shutdown),
+    // then presents a frame if any control changed since the previous one.
+    // Returns the number of changed controls.
+    int renderAll() {
+        // wait() clears the mask, so updates landing mid-frame schedule the next one.
+        if (m_renderChanges.wait() == 0) {
+            return 0; // Woken for shutdown
+        }
+        return drawDirty();
     }
 
-    void renderAll() {
-        std::unique_lock<std::mutex> lock(m_managerMutex);
-        g_renderCondition.wait(lock, []{ return true; }); // Simply wait to ensure render is called after updates
-        std::lock_guard<std::mutex> consoleLock(g_consoleMutex); // Protect console output for entire render
-        std::cout << "\n--- Climate Control Status ---" << std::endl;
-        for (auto const& control : m_controls) { // Using auto for iteration
-            control->render();
+    // Non-blocking variant for callers that drive render ticks themselves,
+    // such as the virtual-time simulation.
+    int renderDirty() {
+        m_renderChanges.poll();
+        return drawDirty();
+    }
+
+private:
+    int drawDirty() {
+        HVAC_LOCK_SITE();
+        std::lock_guard<ProfiledMutex> consoleLock(g_consoleMutex); // Protect console output for entire render
+        auto controls = m_controls.read(); // Pinned snapshot; configuration changes don't wait for us
+        int drawn = 0;
+        for (auto const& control : controls->controls()) { // Using auto for iteration
+            if (control->consumeDirty()) {
+                ++drawn;
+            }
         }
-        std::cout << "----------------------------" << std::endl;
+        if (drawn == 0) {
+            return 0;
+        }
+        // Compose the whole screen in memory; present() rewrites only changed cells
+        std::ostream& out = m_frame.begin();
+        out << "--- Climate Control Status ---\n";
+        for (auto const& control : controls->controls()) {
+            control->render(out);
+        }
+        out << "----------------------------\n";
+        m_frame.present();
+        return drawn;
     }
 };
 
-// Thread functions
-void temperatureUpdater(std::shared_ptr<TemperatureControlScreen> tempControl) {
-    // Removed 'register' keyword to fix the warning
-    int counter = 0; 
-    while (g_keepRunning) {
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-        if (!g_keepRunning) break;
+// Periodic updater bodies. Each call performs one update step; the
+// TimerWheelScheduler in main runs them, so no thread sleeps per updater.
+void temperatureUpdater(const std::shared_ptr<TemperatureControlScreen>& tempControl) {
+    // setTemperature() takes g_temperatureMutex itself; the read below is
+    // lock-free, so no outer lock is held here (it would self-deadlock).
+    int currentTemp = tempControl->getTemperature();
+    if (currentTemp < 30) { // Cap temperature at 30
+        tempControl->setTemperature(currentTemp + 1); // Increase temperature
+    } else {
+        tempControl->setTemperature(18); // Reset to a lower temp to show change
+    }
+}
+
+// Holds the random generator between scheduled runs.
+struct FanModeUpdater {
+    std::shared_ptr<FanSpeedControlScreen> fanControl;
+    std::shared_ptr<ModeControlScreen> modeControl;
+    // Own stream keyed by the fan control's id; HVAC_SEED makes runs repeatable,
+    // or pass a generator, as --simulate does with its seed.
+    Xoshiro256pp gen = Xoshiro256pp::forStream(Xoshiro256pp::processSeed(),
+                                               static_cast<std::uint64_t>(fanControl->getId()));
+
+    void operator()() {
+        // Setters lock their own mutexes, publish their new values and
+        // mark their control dirty only on change.
+        fanControl->setFanLevel(gen.range(0, fanLimit)); // Using global fanLimit
+        modeControl->setMode(static_cast<ModeControlScreen::Mode>(gen.range(0, 2)));
+    }
+};
 
-        // Fix with std::scoped_lock for consistent ordering
-        std::scoped_lock lock(g_temperatureMutex, g_fanSpeedMutex);
+#if HVAC_HAS_COROUTINES
+// Coroutine forms of the updaters and the render loop (C++20 builds). Each
+// is a Task on an EventLoop, so they share one thread and cost a coroutine
+// frame each instead of a thread stack. Deadlines advance by whole periods,
+// so the schedule does not drift.
+Task temperatureBehavior(std::shared_ptr<TemperatureControlScreen> tempControl, std::chrono::milliseconds period) {
+    PeriodicSchedule schedule("temperatureBehavior", period);
+    for (;;) {
+        co_await sleepUntil(schedule.deadline());
+        schedule.onWake();
+        temperatureUpdater(tempControl);
+    }
+}
 
-        int currentTemp = tempControl->getTemperature();
-        if (currentTemp < 30) { // Cap temperature at 30
-            tempControl->setTemperature(currentTemp + 1); // Increase temperature
-        } else {
-            tempControl->setTemperature(18); // Reset to a lower temp to show change
+Task fanModeBehavior(FanModeUpdater updater, std::chrono::milliseconds period) {
+    PeriodicSchedule schedule("fanModeBehavior", period);
+    for (;;) {
+        co_await sleepUntil(schedule.deadline());
+        schedule.onWake();
+        updater();
+    }
+}
+
+// Draws the dirty controls, then sleeps until g_changeBus reports a change
+// (the loop must watch it).
+Task renderBehavior(ClimateControlManager& manager) {
+    for (;;) {
+        manager.renderDirty();
+        co_await nextChange();
+    }
+}
+
+// One cabin zone's thermostat as a task, for --behaviors.
+Task zoneBehavior(std::vector<int>& temperatures, std::size_t zone, std::chrono::milliseconds period,
+                  std::uint64_t& steps) {
+    auto next = EventLoop::Clock::now();
+    for (;;) {
+        next += period;
+        co_await sleepUntil(next);
+        int& temp = temperatures[zone];
+        temp = temp < 30 ? temp + 1 : 18;
+        ++steps;
+    }
+}
+
+Task stopAfter(EventLoop& loop, std::chrono::seconds duration) {
+    co_await sleepFor(duration);
+    loop.stop();
+}
+
+// Runs many independent zone behaviors on one thread (run with --behaviors N [seconds]).
+void runBehaviorSwarm(std::size_t count, int seconds) {
+    std::vector<int> temperatures(count, 24);
+    std::uint64_t steps = 0;
+    Xoshiro256pp gen(12345);
+    EventLoop loop;
+    for (std::size_t i = 0; i < count; ++i) {
+        loop.spawn(zoneBehavior(temperatures, i, std::chrono::milliseconds(gen.range(50, 500)), steps));
+    }
+    loop.spawn(stopAfter(loop, std::chrono::seconds(seconds)));
+    std::size_t frameBytes = Task::liveFrameBytes();
+
+    auto start = std::chrono::steady_clock::now();
+    loop.run();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "Ran " << count << " zone behaviors on one thread for " << elapsed.count() << " ms: "
+              << steps << " updates, " << frameBytes / 1024 << " KiB of coroutine frames ("
+              << frameBytes / std::max<std::size_t>(count, 1) << " bytes per behavior)" << std::endl;
+}
+#endif
+
+// Bulk simulation over the struct-of-arrays backend (run with --zones N).
+// Applies the same rules as the updater threads to every zone per pass.
+void runZoneSimulation(std::size_t zoneCount, int passes) {
+    ZoneClimateStore store(fanLimit);
+    store.reserve(zoneCount);
+    for (std::size_t i = 0; i < zoneCount; ++i) {
+        store.addZone(24, 2, ZoneClimateStore::AC);
+    }
+
+    Xoshiro256pp gen(12345);
+    std::vector<std::uint8_t> fanLevels(zoneCount);
+    std::vector<std::uint8_t> modes(zoneCount);
+    std::string frame;
+    std::size_t drawn = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        store.updateTemperatures([](int temp) { return temp < 30 ? temp + 1 : 18; });
+        if (pass % 3 == 2) { // Fan/mode change at a third of the temperature rate
+            gen.fillRange(fanLevels.data(), zoneCount, 0, fanLimit);
+            gen.fillRange(modes.data(), zoneCount, 0, 2);
+            store.assignFanLevels(fanLevels.data());
+            store.assignModes(modes.data());
+        }
+        frame.clear();
+        drawn += store.renderAll(frame);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    std::cout << "Simulated " << zoneCount << " zones x " << passes << " passes in "
+              << std::chrono::duration<double, std::milli>(elapsed).count() << " ms (" << drawn << " zone redraws)" << std::endl;
+}
+
+// Fleet of vehicles for --fleet: vehicle v lives on shard v % shards as zone
+// v / shards of that shard's store. Only the shard's thread touches it.
+struct FleetShard {
+    ZoneClimateStore store{fanLimit};
+    Xoshiro256pp gen;
+    std::vector<std::uint8_t> fanLevels;
+    std::vector<std::uint8_t> modes;
+    std::string frame;
+    std::uint64_t passes = 0;
+    std::uint64_t redraws = 0;
+};
+
+struct FleetCommand {
+    std::uint32_t vehicle = 0;
+    InputKind kind = InputKind::Temperature;
+    std::int32_t value = 0;
+};
+
+// Shared-nothing fleet run (--fleet VEHICLES [shards] [seconds]). Each shard
+// runs its vehicles' control passes back to back with no locks. The main
+// thread acts as a command gateway: it posts random setter commands to each
+// vehicle's shard. Every 256th vehicle leads a convoy, and its new mode is
+// sent to the next vehicle, which lives on another shard.
+void runFleet(std::size_t vehicles, unsigned shards, double seconds) {
+    shards = std::max(1u, shards);
+    std::vector<FleetShard> states(shards);
+    for (unsigned i = 0; i < shards; ++i) {
+        std::size_t owned = vehicles / shards + (i < vehicles % shards ? 1 : 0);
+        states[i].store.reserve(owned);
+        for (std::size_t v = 0; v < owned; ++v) {
+            states[i].store.addZone(24, 2, ZoneClimateStore::AC);
+        }
+        states[i].gen = Xoshiro256pp::forStream(Xoshiro256pp::processSeed(), i);
+        states[i].fanLevels.resize(owned);
+        states[i].modes.resize(owned);
+    }
+
+    using Runtime = ShardRuntime<FleetShard, FleetCommand>;
+    auto onCommand = [shards](FleetShard& shard, Runtime::Context&, const FleetCommand& command) {
+        auto zone = static_cast<ZoneClimateStore::ZoneId>(command.vehicle / shards);
+        switch (command.kind) {
+            case InputKind::Temperature: shard.store.setTemperature(zone, command.value); break;
+            case InputKind::FanLevel: shard.store.setFanLevel(zone, command.value); break;
+            case InputKind::Mode: shard.store.setMode(zone, static_cast<ZoneClimateStore::Mode>(command.value)); break;
+        }
+    };
+    auto onPoll = [vehicles](FleetShard& shard, Runtime::Context& context) {
+        const std::size_t owned = shard.store.size();
+        shard.store.updateTemperatures([](int temp) { return temp < 30 ? temp + 1 : 18; });
+        if (shard.passes % 3 == 2) { // Fan/mode change at a third of the temperature rate
+            shard.gen.fillRange(shard.fanLevels.data(), owned, 0, fanLimit);
+            shard.gen.fillRange(shard.modes.data(), owned, 0, 2);
+            shard.store.assignFanLevels(shard.fanLevels.data());
+            shard.store.assignModes(shard.modes.data());
+            for (std::size_t zone = 0; zone < owned; ++zone) {
+                std::size_t vehicle = zone * context.shardCount() + context.shard();
+                if (vehicle % 256 == 0 && vehicle + 1 < vehicles) {
+                    FleetCommand follow{static_cast<std::uint32_t>(vehicle + 1), InputKind::Mode, shard.modes[zone]};
+                    context.send(static_cast<unsigned>((vehicle + 1) % context.shardCount()), follow);
+                }
+            }
+        }
+        shard.frame.clear();
+        shard.redraws += shard.store.renderAll(shard.frame);
+        ++shard.passes;
+        return true;
+    };
+
+    Runtime runtime(std::move(states), onCommand, onPoll);
+    Xoshiro256pp gen(12345);
+    std::uint64_t posted = 0;
+    std::uint64_t rejected = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(seconds));
+    runtime.start();
+    while (std::chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 256; ++i) {
+            FleetCommand command;
+            command.vehicle = static_cast<std::uint32_t>(gen.below(static_cast<std::uint32_t>(vehicles)));
+            command.kind = static_cast<InputKind>(gen.range(1, 3));
+            command.value = command.kind == InputKind::Temperature ? gen.range(15, 30)
+                          : command.kind == InputKind::FanLevel ? gen.range(0, fanLimit) : gen.range(0, 2);
+            if (runtime.post(command.vehicle % shards, command)) {
+                ++posted;
+            } else {
+                ++rejected; // Shard busy; a real gateway would retry
+            }
+        }
+        std::this_thread::yield();
+    }
+    runtime.stop();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::uint64_t vehicleUpdates = 0;
+    std::uint64_t handled = 0;
+    std::uint64_t sent = 0;
+    std::uint64_t deferred = 0;
+    long long temperatureSum = 0;
+    for (unsigned i = 0; i < shards; ++i) {
+        const FleetShard& shard = runtime.state(i);
+        vehicleUpdates += shard.passes * shard.store.size();
+        handled += runtime.stats(i).handled;
+        sent += runtime.stats(i).sent;
+        deferred += runtime.stats(i).deferred;
+        for (ZoneClimateStore::ZoneId zone = 0; zone < shard.store.size(); ++zone) {
+            temperatureSum += shard.store.getTemperature(zone);
         }
-        
+        std::cout << "  shard " << i << ": " << shard.store.size() << " vehicles, " << shard.passes << " passes, "
+                  << shard.redraws << " redraws, " << runtime.stats(i).handled << " messages" << std::endl;
+    }
+    std::cout << "Fleet of " << vehicles << " vehicles on " << shards << " shard(s) for " << elapsed << " s: "
+              << static_cast<double>(vehicleUpdates) / elapsed / 1e6 << " M vehicle-updates/s, "
+              << posted << " commands posted (" << rejected << " rejected), " << sent << " cross-shard ("
+              << deferred << " deferred), " << handled << " handled; mean temperature "
+              << static_cast<double>(temperatureSum) / static_cast<double>(std::max<std::size_t>(vehicles, 1))
+              << "\u00B0C" << std::endl;
+}
+
+// Closed-loop PID run over many zones (run with --thermal N [seconds], N >= 1).
+// Every zone starts away from its setpoint and is driven there by its controller.
+void runThermalSimulation(std::size_t zoneCount, int simSeconds) {
+    const float dt = 0.1f;
+    ZoneThermalBatch batch;
+    Xoshiro256pp gen(12345);
+    std::vector<float> starts(zoneCount);
+    std::vector<float> setpoints(zoneCount);
+    gen.fillUniform(starts.data(), zoneCount, 10.0f, 35.0f);
+    gen.fillUniform(setpoints.data(), zoneCount, 18.0f, 26.0f);
+    for (std::size_t i = 0; i < zoneCount; ++i) {
+        batch.addZone(starts[i], setpoints[i], 5.0f);
+    }
+
+    int steps = static_cast<int>(static_cast<float>(simSeconds) / dt);
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; ++step) {
+        batch.step(dt);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    std::cout << "Thermal model (" << (ZoneThermalBatch::vectorized() ? "AVX2" : "scalar") << "): "
+              << zoneCount << " zones x " << steps << " steps in " << std::chrono::duration<double, std::milli>(elapsed).count() << " ms, "
+              << "zone 0 at " << batch.temperature(0) << "\u00B0C" << std::endl;
+}
+
+// --restore FILE: picks up where a --snapshot run left off. A missing or
+// unreadable snapshot is reported and the run starts from the defaults.
+void restoreManager(ClimateControlManager& manager, const std::string& path) {
+    if (path.empty()) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    try {
+        int restored = manager.restoreSnapshot(path);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Restored " << restored << " control(s) from " << path << " in " << elapsed.count() << " ms"
+                  << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "; starting from defaults" << std::endl;
+    }
+}
 
-        g_renderCondition.notify_one(); // Notify manager to re-render
-        counter++;
+// --snapshot FILE: saves the final state for a later --restore.
+void saveManager(const ClimateControlManager& manager, const std::string& path) {
+    if (path.empty()) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    try {
+        manager.saveSnapshot(path);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Saved snapshot " << path << " in " << elapsed.count() << " ms" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
     }
 }
 
-void fanModeUpdater(std::shared_ptr<FanSpeedControlScreen> fanControl,
-                    std::shared_ptr<ModeControlScreen> modeControl) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> fanDist(0, fanLimit); // Using global fanLimit
-    std::uniform_int_distribution<> modeDist(0, 2);
+// Runs the three controls in virtual time (run with --simulate HOURS [seed]).
+// Updaters and render ticks fire in timestamp order with no real sleeping,
+// so a given seed always produces the same frames and final state.
+void runVirtualSimulation(double hours, unsigned seed, const std::string& restorePath,
+                          const std::string& snapshotPath) {
+    VirtualClock clock;
+    g_telemetryClock = &clock; // Log virtual timestamps, starting with the initial state
+    ClimateControlManager manager;
+    auto tempControl = std::make_shared<TemperatureControlScreen>(24);
+    auto fanControl = std::make_shared<FanSpeedControlScreen>(2);
+    auto modeControl = std::make_shared<ModeControlScreen>(ModeControlScreen::AC);
+    manager.addControl(tempControl);
+    manager.addControl(fanControl);
+    manager.addControl(modeControl);
+    restoreManager(manager, restorePath);
+
+    SimulationLoop loop(clock);
+    int frames = 0;
+    loop.every(std::chrono::seconds(2), [tempControl] { temperatureUpdater(tempControl); });
+    loop.every(std::chrono::seconds(3), FanModeUpdater{fanControl, modeControl, Xoshiro256pp(seed)});
+    loop.every(std::chrono::seconds(1), [&manager, &frames] {
+        if (manager.renderDirty() > 0) {
+            ++frames;
+        }
+    });
+
+    auto wallStart = std::chrono::steady_clock::now();
+    std::uint64_t events = loop.runFor(std::chrono::duration<double, std::ratio<3600>>(hours));
+    auto wall = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - wallStart);
+
+    std::cout << "Simulated " << hours << " h (" << events << " events, " << frames << " frames) in "
+              << wall.count() << " ms. Final: " << tempControl->getTemperature() << "\u00B0C, fan "
+              << fanControl->getFanLevel() << ", " << modeControl->modeToString(modeControl->getMode())
+              << " (seed " << seed << ")" << std::endl;
+    std::cout << "Temperature";
+    writeRollingSummaries(std::cout, tempControl->getTemperatureStats(), tempControl->statWindowCount());
+    std::cout << "Fan level";
+    writeRollingSummaries(std::cout, fanControl->getFanLevelStats(), fanControl->statWindowCount());
+    saveManager(manager, snapshotPath); // Before the clock goes, so sample ages are in virtual time
+    g_telemetryClock = nullptr;
+}
+
+// Summarizes the last `hours` of a telemetry log (run with --scan-log DIR [hours]).
+void scanTelemetryLog(const std::string& directory, double hours) {
+    TelemetryLogReader reader(directory);
+    std::int64_t to = reader.lastTimestamp() + 1;
+    std::int64_t from = to - static_cast<std::int64_t>(hours * 3600e9);
 
-    while (g_keepRunning) {
-        std::this_thread::sleep_for(std::chrono::seconds(3));
-        if (!g_keepRunning) break;
+    std::uint64_t counts[4] = {};
+    int minTemp = 0, maxTemp = 0;
+    double tempSum = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t visited = reader.scan(from, to, [&](const TelemetryRecord& record) {
+        counts[static_cast<std::size_t>(record.kind) & 3]++;
+        if (record.kind == TelemetryKind::Temperature) {
+            minTemp = counts[1] == 1 ? record.value : std::min(minTemp, static_cast<int>(record.value));
+            maxTemp = counts[1] == 1 ? record.value : std::max(maxTemp, static_cast<int>(record.value));
+            tempSum += record.value;
+        }
+    });
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
 
-        // Acquire fan and mode mutexes
-        std::scoped_lock lock(g_fanSpeedMutex, g_modeMutex);
+    std::cout << "Scanned " << visited << " of " << reader.recordCount() << " records in "
+              << reader.segmentCount() << " segment(s) in " << elapsed.count() << " ms: "
+              << counts[1] << " temperature, " << counts[2] << " fan, " << counts[3] << " mode changes";
+    if (counts[1] > 0) {
+        std::cout << "; temperature " << minTemp << ".." << maxTemp << "\u00B0C, mean "
+                  << tempSum / static_cast<double>(counts[1]);
+    }
+    std::cout << std::endl;
+}
 
-        fanControl->setFanLevel(fanDist(gen));
-        modeControl->setMode(static_cast<ModeControlScreen::Mode>(modeDist(gen)));
+// --watch NAME [hz]: read-only view of another process's --publish segment.
+// Polls at its own rate, never blocks the publisher, and prints only when the
+// published version changes.
+void watchSharedState(const std::string& name, double hz) {
+    SharedStateReader<HVACState> reader(name);
+    static const char* const kModeNames[] = {"AC", "Heater", "Auto"};
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / std::max(hz, 0.1)));
+    std::cout << "Watching " << name << " (publisher pid " << reader.publisherPid() << ") at "
+              << hz << " Hz" << std::endl;
 
-        g_renderCondition.notify_one(); // Notify manager to re-render
+    std::uint64_t shownVersion = ~std::uint64_t(0);
+    std::uint64_t polls = 0;
+    std::uint64_t contended = 0;
+    auto next = std::chrono::steady_clock::now();
+    while (reader.publisherOpen()) {
+        ++polls;
+        std::uint64_t version = reader.version();
+        if (version != shownVersion) {
+            HVACState state{};
+            if (reader.read(state)) {
+                shownVersion = version;
+                const char* mode = state.mode >= 0 && state.mode < 3 ? kModeNames[state.mode] : "?";
+                std::cout << "[v" << version << "] " << state.temperature << "\u00B0C, fan "
+                          << state.fanLevel << ", mode " << mode << std::endl;
+            } else {
+                ++contended; // Writer mid-publish on every attempt; try again next tick
+            }
+        }
+        next += period;
+        std::this_thread::sleep_until(next);
     }
+    std::cout << "Publisher closed after " << polls << " polls (" << contended << " contended)" << std::endl;
 }
 
-int main() {
+// --replay FILE [speed|max]: feeds a --record trace into fresh controls. Paced
+// replays render as they go; "max" skips rendering and measures the control path.
+// The digest covers the published state after every call, so two replays (or
+// two builds) that behave identically print the same value.
+void replayInputs(const std::string& path, double speed) {
+    InputTrace trace = InputTrace::load(path);
+    ClimateControlManager manager;
+    auto tempControl = std::make_shared<TemperatureControlScreen>(24);
+    auto fanControl = std::make_shared<FanSpeedControlScreen>(2);
+    auto modeControl = std::make_shared<ModeControlScreen>(ModeControlScreen::AC);
+    manager.addControl(tempControl);
+    manager.addControl(fanControl);
+    manager.addControl(modeControl);
+
+    std::thread renderThread;
+    if (speed > 0) {
+        renderThread = std::thread([&manager] {
+            applyThreadPlacement(ThreadRole::Render, std::cerr);
+            while (g_keepRunning) {
+                manager.renderAll();
+            }
+        });
+    }
+    applyThreadPlacement(ThreadRole::Control, std::cerr); // This thread drives the setters
+
+    std::uint64_t digest = 14695981039346656037ull; // FNV-1a
+    auto mix = [&digest](int value) {
+        digest = (digest ^ static_cast<std::uint32_t>(value)) * 1099511628211ull;
+    };
+    ReplayStats stats = replayTrace(trace, speed, [&](const InputEvent& event) {
+        switch (event.kind) {
+            case InputKind::Temperature: tempControl->setTemperature(event.value); break;
+            case InputKind::FanLevel: fanControl->setFanLevel(event.value); break;
+            case InputKind::Mode:
+                if (ModeControlScreen::isValidMode(event.value)) {
+                    modeControl->setMode(static_cast<ModeControlScreen::Mode>(event.value));
+                }
+                break;
+        }
+        mix(tempControl->getTemperature());
+        mix(fanControl->getFanLevel());
+        mix(modeControl->getMode());
+    });
+
+    if (renderThread.joinable()) {
+        g_keepRunning = false;
+        g_changeBus.close();
+        renderThread.join();
+    }
+    double seconds = std::chrono::duration<double>(stats.elapsed).count();
+    std::lock_guard<ProfiledMutex> consoleLock(g_consoleMutex);
+    std::cout << "Replayed " << stats.events << " of " << trace.events.size() << " inputs ("
+              << std::chrono::duration<double>(trace.duration()).count() << " s recorded, seed " << trace.seed
+              << ") in " << seconds * 1000.0 << " ms";
+    if (speed > 0) {
+        std::cout << ", max lateness " << std::chrono::duration<double, std::micro>(stats.maxLateness).count() << " us";
+    } else if (seconds > 0) {
+        std::cout << ", " << static_cast<double>(stats.events) / seconds << " inputs/s";
+    }
+    std::cout << ". Final: " << tempControl->getTemperature() << "\u00B0C, fan " << fanControl->getFanLevel()
+              << ", " << modeControl->modeToString(modeControl->getMode()) << " (digest " << std::hex << digest
+              << std::dec << ")" << std::endl;
+}
+
+// Applies one remote request to the controls and answers with their
+// published state. Runs on the control server's thread; the setters do their
+// own locking and mark their controls dirty, as local updates do.
+ControlResponse handleControlRequest(const ControlRequest& request, TemperatureControlScreen& tempControl,
+                                     FanSpeedControlScreen& fanControl, ModeControlScreen& modeControl) {
+    switch (request.op) {
+        case ControlOp::SetTemperature: tempControl.setTemperature(request.value); break;
+        case ControlOp::SetFanLevel: fanControl.setFanLevel(request.value); break;
+        case ControlOp::SetMode:
+            if (ModeControlScreen::isValidMode(request.value)) {
+                modeControl.setMode(static_cast<ModeControlScreen::Mode>(request.value));
+            }
+            break;
+        case ControlOp::GetState: break;
+    }
+    return ControlResponse{request.id, ControlStatus::Ok, tempControl.getTemperature(), fanControl.getFanLevel(),
+                           modeControl.getMode()};
+}
+
+// --load-test PATH [clients] [seconds] [depth]: opens clients connections to
+// a --serve socket, spread over a few threads. Each connection repeatedly
+// writes depth pipelined requests in one send and waits for the answers.
+// Latency is measured per batch, from the send until the last response.
+void runControlLoadTest(const std::string& path, std::size_t clients, double seconds, std::size_t depth) {
+    control_protocol::raiseFileLimit();
+    clients = std::max<std::size_t>(clients, 1);
+    depth = std::max<std::size_t>(depth, 1);
+    unsigned threadCount = static_cast<unsigned>(
+        std::min<std::size_t>(clients, std::max(2u, std::thread::hardware_concurrency())));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(seconds));
+
+    struct Worker {
+        std::vector<ControlClient> connections;
+        std::vector<std::uint32_t> latenciesNs;
+        std::uint64_t requests = 0;
+        std::uint64_t errors = 0;
+        std::size_t failedConnections = 0; // Dropped by the server mid-run
+    };
+    std::vector<Worker> workers(threadCount);
+    for (std::size_t c = 0; c < clients; ++c) {
+        workers[c % threadCount].connections.emplace_back(path); // Throws if the server is not running
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&worker = workers[t], t, depth, deadline] {
+            Xoshiro256pp gen = Xoshiro256pp::forStream(Xoshiro256pp::processSeed(), t);
+            std::vector<std::chrono::steady_clock::time_point> sentAt(worker.connections.size());
+            std::vector<ControlResponse> responses;
+            std::vector<char> failed(worker.connections.size(), 0);
+            std::uint32_t nextId = 0;
+            // send() and receive() throw once the server goes away; that
+            // connection is counted as failed and the others carry on.
+            auto fail = [&worker, &failed](std::size_t c) {
+                failed[c] = 1;
+                ++worker.failedConnections;
+            };
+            while (std::chrono::steady_clock::now() < deadline &&
+                   worker.failedConnections < worker.connections.size()) {
+                for (std::size_t c = 0; c < worker.connections.size(); ++c) {
+                    if (failed[c]) {
+                        continue;
+                    }
+                    for (std::size_t i = 0; i < depth; ++i) {
+                        ControlRequest request;
+                        request.id = nextId++;
+                        request.op = static_cast<ControlOp>(gen.range(1, 4));
+                        request.value = request.op == ControlOp::SetTemperature ? gen.range(15, 30)
+                                      : request.op == ControlOp::SetFanLevel ? gen.range(0, fanLimit)
+                                      : gen.range(0, 2);
+                        worker.connections[c].queue(request);
+                    }
+                    sentAt[c] = std::chrono::steady_clock::now();
+                    try {
+                        worker.connections[c].send();
+                    } catch (const std::exception&) {
+                        fail(c);
+                    }
+                }
+                for (std::size_t c = 0; c < worker.connections.size(); ++c) {
+                    if (failed[c]) {
+                        continue;
+                    }
+                    responses.clear();
+                    try {
+                        worker.connections[c].receive(depth, responses);
+                    } catch (const std::exception&) {
+                        fail(c);
+                        continue;
+                    }
+                    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - sentAt[c]).count();
+                    worker.latenciesNs.push_back(static_cast<std::uint32_t>(std::min<long long>(latency, UINT32_MAX)));
+                    worker.requests += depth;
+                    for (const ControlResponse& response : responses) {
+                        worker.errors += response.status != ControlStatus::Ok;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::uint32_t> latencies;
+    std::uint64_t requests = 0;
+    std::uint64_t errors = 0;
+    std::size_t failedConnections = 0;
+    for (const Worker& worker : workers) {
+        latencies.insert(latencies.end(), worker.latenciesNs.begin(), worker.latenciesNs.end());
+        requests += worker.requests;
+        errors += worker.errors;
+        failedConnections += worker.failedConnections;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentileUs = [&latencies](double fraction) {
+        if (latencies.empty()) {
+            return 0.0;
+        }
+        std::size_t index = std::min(latencies.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(latencies.size())));
+        return latencies[index] / 1000.0;
+    };
+    std::cout << clients << " clients x depth " << depth << " on " << threadCount << " threads for " << elapsed
+              << " s: " << requests << " requests (" << static_cast<double>(requests) / elapsed / 1e3
+              << " k/s), " << errors << " errors, " << failedConnections << " failed connections; batch latency us p50 "
+              << percentileUs(0.50) << ", p99 " << percentileUs(0.99) << ", max " << percentileUs(1.0) << std::endl;
+}
+
+// --latency-probe [seconds]: 1 ms probe loop under redraw-like load on every
+// CPU, first with default scheduling, then with the --placement /
+// HVAC_PLACEMENT config (control=*:fifo80 if none is given).
+void runLatencyProbeCommand(double seconds) {
+    PlacementConfig config = PlacementConfig::current();
+    if (config.empty()) {
+        config = PlacementConfig::parse("control=*:fifo80");
+    }
+    auto half = std::chrono::milliseconds(static_cast<long long>(seconds * 500.0));
+    LatencyProbeResult before = runLatencyProbe("probe (default scheduling)", config, false, half, std::cerr);
+    LatencyProbeResult after = runLatencyProbe("probe (placed)", config, true, half, std::cerr);
+    for (const LatencyProbeResult* result : {&before, &after}) {
+        result->stats->report(std::cout);
+        std::cout << "  competing redraw bursts: " << result->loadBursts << "\n";
+    }
+    std::cout << "p99 wake latency " << static_cast<double>(before.stats->latencyPercentile(0.99)) / 1000.0
+              << " us -> " << static_cast<double>(after.stats->latencyPercentile(0.99)) / 1000.0 << " us, missed " << before.stats->misses()
+              << " -> " << after.stats->misses() << std::endl;
+}
+
+#ifdef HVAC_BENCH
+// Bench entry point (see hvac_bench.h), built in place of main().
+Variant makeBenchVariant() {
+    struct State {
+        ClimateControlManager manager;
+        std::shared_ptr<TemperatureControlScreen> temp = std::make_shared<TemperatureControlScreen>(24);
+        std::shared_ptr<FanSpeedControlScreen> fan = std::make_shared<FanSpeedControlScreen>(2);
+        std::shared_ptr<ModeControlScreen> mode = std::make_shared<ModeControlScreen>();
+        State() {
+            manager.addControl(temp);
+            manager.addControl(fan);
+            manager.addControl(mode);
+        }
+    };
+    auto s = std::make_shared<State>();
+    State* p = s.get();
+    return Variant{"check",
+                   {{"setTemperature", OpKind::Write, [p](unsigned v) { p->temp->setTemperature(15 + static_cast<int>(v % 16)); }},
+                    {"getTemperature", OpKind::Read, [p](unsigned) { (void)p->temp->getTemperature(); }},
+                    {"setFanLevel", OpKind::Write, [p](unsigned v) { p->fan->setFanLevel(static_cast<int>(v % 6)); }},
+                    {"getFanLevel", OpKind::Read, [p](unsigned) { (void)p->fan->getFanLevel(); }},
+                    {"setMode", OpKind::Write, [p](unsigned v) { p->mode->setMode(static_cast<ModeControlScreen::Mode>(v % 3)); }},
+                    {"getMode", OpKind::Read, [p](unsigned) { (void)p->mode->getMode(); }},
+                    {"renderAll", OpKind::Render, [p](unsigned) { p->manager.renderDirty(); }}},
+                   s};
+}
+#else
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && std::string(argv[1]) == "--scan-log") {
+        try {
+            scanTelemetryLog(argv[2], argc >= 4 ? std::stod(argv[3]) : 24.0);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    try {
+        PlacementConfig::current() = PlacementConfig::fromEnvironment();
+    } catch (const std::exception& e) {
+        std::cerr << "HVAC_PLACEMENT: " << e.what() << std::endl;
+        return 1;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--load-test") {
+        try {
+            runControlLoadTest(argv[2], argc >= 4 ? std::stoul(argv[3]) : 64, argc >= 5 ? std::stod(argv[4]) : 3.0,
+                               argc >= 6 ? std::stoul(argv[5]) : 16);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--watch") {
+        try {
+            watchSharedState(argv[2], argc >= 4 ? std::stod(argv[3]) : 10.0);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    // Trailing options, in any order and for the interactive, --simulate and
+    // --replay runs: "--log DIR" records every change; "--publish NAME" mirrors
+    // the state into shared memory for --watch; "--record FILE" traces every
+    // setter call for --replay; "--placement SPEC" pins and prioritizes threads
+    // (see hvac_thread_placement.h) and overrides HVAC_PLACEMENT; "--serve PATH"
+    // accepts remote control requests on a Unix socket (interactive run);
+    // "--restore FILE" starts from a saved snapshot and "--snapshot FILE"
+    // saves one at exit (interactive and --simulate runs).
+    std::string servePath;
+    std::string restorePath;
+    std::string snapshotPath;
+    while (argc >= 3) {
+        std::string option = argv[argc - 2];
+        try {
+            if (option == "--log") {
+                g_telemetryLog = std::make_unique<TelemetryLogWriter>(argv[argc - 1]);
+                g_telemetryLog->setErrorHandler([](const std::string& message) {
+                    std::lock_guard<ProfiledMutex> consoleLock(g_consoleMutex);
+                    std::cerr << message << std::endl;
+                });
+            } else if (option == "--serve") {
+                servePath = argv[argc - 1];
+            } else if (option == "--restore") {
+                restorePath = argv[argc - 1];
+            } else if (option == "--snapshot") {
+                snapshotPath = argv[argc - 1];
+            } else if (option == "--placement") {
+                PlacementConfig::current() = PlacementConfig::parse(argv[argc - 1]);
+            } else if (option == "--record") {
+                g_inputRecorder = std::make_unique<InputRecorder>(argv[argc - 1], Xoshiro256pp::processSeed());
+            } else if (option == "--publish") {
+                g_sharedState = std::make_unique<SharedStatePublisher<HVACState>>(argv[argc - 1], g_hvacState.load());
+            } else {
+                break;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        argc -= 2;
+    }
+    applyMemoryLock(std::cerr);
+    if (argc >= 2 && std::string(argv[1]) == "--latency-probe") {
+        runLatencyProbeCommand(argc >= 3 ? std::stod(argv[2]) : 4.0);
+        return 0;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--replay") {
+        try {
+            replayInputs(argv[2], argc >= 4 ? parseReplaySpeed(argv[3]) : 1.0);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--behaviors") {
+#if HVAC_HAS_COROUTINES
+        runBehaviorSwarm(std::stoul(argv[2]), argc >= 4 ? std::stoi(argv[3]) : 5);
+        return 0;
+#else
+        std::cerr << "--behaviors needs a C++20 build (e.g. -std=c++20)" << std::endl;
+        return 1;
+#endif
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--zones") {
+        runZoneSimulation(std::stoul(argv[2]), argc >= 4 ? std::stoi(argv[3]) : 100);
+        return 0;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--fleet") {
+        // Signed parse: std::stoul would turn "-1" into a huge vehicle count.
+        long long vehicles = 0;
+        long long shards = std::max(1u, std::thread::hardware_concurrency());
+        double seconds = 3.0;
+        try {
+            vehicles = std::stoll(argv[2]);
+            if (argc >= 4) {
+                shards = std::stoll(argv[3]);
+            }
+            if (argc >= 5) {
+                seconds = std::stod(argv[4]);
+            }
+        } catch (const std::exception&) {
+            std::cerr << "usage: --fleet VEHICLES [shards] [seconds]" << std::endl;
+            return 1;
+        }
+        if (vehicles <= 0 || shards <= 0) {
+            std::cerr << "--fleet needs at least one vehicle and one shard" << std::endl;
+            return 1;
+        }
+        runFleet(static_cast<std::size_t>(vehicles), static_cast<unsigned>(std::min(shards, vehicles)), seconds);
+        return 0;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--thermal") {
+        std::size_t zones = std::stoul(argv[2]);
+        if (zones == 0) {
+            std::cerr << "--thermal needs at least one zone" << std::endl;
+            return 1;
+        }
+        runThermalSimulation(zones, argc >= 4 ? std::stoi(argv[3]) : 600);
+        return 0;
+    }
+    if (argc >= 3 && std::string(argv[1]) == "--simulate") {
+        runVirtualSimulation(std::stod(argv[2]), argc >= 4 ? static_cast<unsigned>(std::stoul(argv[3])) : 1u,
+                             restorePath, snapshotPath);
+        return 0;
+    }
+
     ClimateControlManager manager;
 
     // Use unique_ptr to manage individual screen instances initially
@@ -274,33 +1483,97 @@ int main() {
     manager.addControl(std::move(fanScreen));
     manager.addControl(std::move(modeScreen));
 
-    // Get shared_ptr references for threads by casting from the manager's vector
-    std::shared_ptr<TemperatureControlScreen> sharedTemp = std::dynamic_pointer_cast<TemperatureControlScreen>(manager.getControls()[0]);
-    std::shared_ptr<FanSpeedControlScreen> sharedFan = std::dynamic_pointer_cast<FanSpeedControlScreen>(manager.getControls()[1]);
-    std::shared_ptr<ModeControlScreen> sharedMode = std::dynamic_pointer_cast<ModeControlScreen>(manager.getControls()[2]);
+    // Get typed shared_ptr references for the updaters from the manager's registry
+    std::shared_ptr<TemperatureControlScreen> sharedTemp = manager.getControl<TemperatureControlScreen>();
+    std::shared_ptr<FanSpeedControlScreen> sharedFan = manager.getControl<FanSpeedControlScreen>();
+    std::shared_ptr<ModeControlScreen> sharedMode = manager.getControl<ModeControlScreen>();
+    restoreManager(manager, restorePath); // Before any updater or renderer runs
 
+    std::unique_ptr<ControlServer> server;
+    if (!servePath.empty()) {
+        try {
+            server = std::make_unique<ControlServer>(servePath, [&](const ControlRequest& request) {
+                return handleControlRequest(request, *sharedTemp, *sharedFan, *sharedMode);
+            });
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
 
-    // Create threads
-    std::thread tempThread(temperatureUpdater, sharedTemp);
-    std::thread fanModeThread(fanModeUpdater, sharedFan, sharedMode);
-
-    // Main loop for rendering
     std::cout << "Starting Climate Control Simulation. Press Enter to exit." << std::endl;
-    manager.renderAll(); // Initial render
+
+#if HVAC_HAS_COROUTINES
+    // Both updaters and the renderer are coroutines on a single event-loop thread.
+    // The first render draws everything, since controls start dirty.
+    EventLoop loop;
+    loop.watch(g_changeBus);
+    loop.spawn(temperatureBehavior(sharedTemp, std::chrono::seconds(2)));
+    loop.spawn(fanModeBehavior(FanModeUpdater{sharedFan, sharedMode}, std::chrono::seconds(3)));
+    loop.spawn(renderBehavior(manager));
+    std::thread loopThread([&loop] {
+        applyThreadPlacement(ThreadRole::Control, std::cerr); // Render rides along as a coroutine
+        loop.run();
+    });
+#else
+    // Both updaters share one scheduler thread instead of sleeping threads of their own.
+    // The wheel already fires on a fixed grid; the schedules measure how late each tick lands.
+    TimerWheelScheduler scheduler;
+    scheduler.setThreadInit([] { applyThreadPlacement(ThreadRole::Control, std::cerr); });
+    auto tempSchedule = std::make_shared<PeriodicSchedule>("temperatureUpdater", std::chrono::seconds(2));
+    auto fanModeSchedule = std::make_shared<PeriodicSchedule>("FanModeUpdater", std::chrono::seconds(3));
+    scheduler.schedulePeriodic(std::chrono::seconds(2), [sharedTemp, tempSchedule] {
+        tempSchedule->onWake();
+        temperatureUpdater(sharedTemp);
+    });
+    scheduler.schedulePeriodic(std::chrono::seconds(3), [updater = FanModeUpdater{sharedFan, sharedMode},
+                                                         fanModeSchedule]() mutable {
+        fanModeSchedule->onWake();
+        updater();
+    });
+    scheduler.start();
+
+    // Render loop: sleeps until a control changes, then redraws only what changed.
+    // The first pass draws everything, since controls start dirty.
+    std::thread renderThread([&manager] {
+        applyThreadPlacement(ThreadRole::Render, std::cerr);
+        while (g_keepRunning) {
+            manager.renderAll();
+        }
+    });
+#endif
+    // After the threads above start, so they don't inherit the main thread's placement.
+    applyThreadPlacement(ThreadRole::Logging, std::cerr);
 
     std::string line;
     std::getline(std::cin, line); // Wait for user input to exit
 
     g_keepRunning = false; // Signal threads to stop
+    if (server) {
+        {
+            std::lock_guard<ProfiledMutex> consoleLock(g_consoleMutex); // The render loop is still drawing
+            std::cout << "Control server: " << server->requestsServed() << " requests from "
+                      << server->connectionsAccepted() << " connections" << std::endl;
+        }
+        server.reset(); // No more remote setter calls from here on
+    }
 
-    // Notify condition variable to unblock any waiting threads before joining
-    g_renderCondition.notify_all();
+    g_changeBus.close(); // Wakes the render loop so it can see g_keepRunning
 
-    tempThread.join(); // Wait for threads to finish
-    fanModeThread.join();
+#if HVAC_HAS_COROUTINES
+    loop.stop(); // Suspended behaviors are destroyed with the loop
+    loopThread.join();
+#else
+    scheduler.stop(); // Returns promptly; does not wait out the 3 s period
+    renderThread.join();
+#endif
+    saveManager(manager, snapshotPath); // Updaters have stopped, so this is the final state
 
-    std::lock_guard<std::mutex> consoleLock(g_consoleMutex);
+    std::lock_guard<ProfiledMutex> consoleLock(g_consoleMutex);
     std::cout << "Simulation ended." << std::endl;
+    ProfiledMutex::reportAll(std::cout); // No-op unless built with -DHVAC_PROFILE_LOCKS
+    LoopStats::reportAll(std::cout); // Deadline misses and wake-up jitter per updater loop
 
     return 0;
-}
\ No newline at end of file
+}
+#endif // HVAC_BENCH
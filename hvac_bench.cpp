@@ -0,0 +1,231 @@
+// hvac_bench.cpp
+// Microbenchmark for the HVAC control getters/setters and renderAll across
+// the check.cpp and .vscode/today*.cpp variants (plus today2/today4's
+// updateAllSettings() pass, joined on the work-stealing pool).
+//
+// Each variant is its own translation unit, linked with this file into one
+// binary per variant (see hvac_bench.h):
+//   g++ -O2 -std=c++17 -pthread -DHVAC_BENCH hvac_bench.cpp check.cpp -o hvac_bench_check
+//   g++ -O2 -std=c++17 -pthread -DHVAC_BENCH hvac_bench.cpp .vscode/today2.cpp -o hvac_bench_today2
+//   (likewise .vscode/today.cpp and .vscode/today4.cpp)
+// Usage: hvac_bench_<variant> [--threads N] [--seconds S] [--read-ratio R] [--render-ratio R]
+//
+// For each thread count 1, 2, 4, ... N, worker threads issue a random mix
+// of reads, writes and renders for S seconds. One JSON object per run is
+// printed to stdout (ops/sec plus p50/p99/p999 latency, overall and per
+// operation) so runs can be diffed. Render output from the variant is
+// discarded while measuring, and FrameCompositor runs headless.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hvac_bench.h" // Variant, Operation, makeBenchVariant()
+
+// Log-linear latency histogram: 8 sub-buckets per power of two (~12% error).
+class LatencyHistogram {
+public:
+    void record(std::uint64_t ns) {
+        ++m_counts[bucketFor(ns)];
+        ++m_total;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_total += other.m_total;
+    }
+
+    std::uint64_t count() const { return m_total; }
+
+    // Upper bound of the bucket holding the requested quantile.
+    std::uint64_t quantile(double q) const {
+        if (m_total == 0) {
+            return 0;
+        }
+        auto target = static_cast<std::uint64_t>(q * static_cast<double>(m_total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            seen += m_counts[i];
+            if (seen >= target) {
+                return upperBound(i);
+            }
+        }
+        return upperBound(kBuckets - 1);
+    }
+
+private:
+    static constexpr int kSubBits = 3;
+    static constexpr std::size_t kBuckets = 64 << kSubBits;
+
+    static std::size_t bucketFor(std::uint64_t ns) {
+        if (ns < (1u << kSubBits)) {
+            return static_cast<std::size_t>(ns);
+        }
+        int msb = 63 - __builtin_clzll(ns);
+        std::uint64_t sub = (ns >> (msb - kSubBits)) & ((1u << kSubBits) - 1);
+        return (static_cast<std::size_t>(msb - kSubBits + 1) << kSubBits) + static_cast<std::size_t>(sub);
+    }
+
+    static std::uint64_t upperBound(std::size_t bucket) {
+        if (bucket < (1u << kSubBits)) {
+            return bucket;
+        }
+        std::size_t exponent = (bucket >> kSubBits) + kSubBits - 1;
+        std::uint64_t sub = bucket & ((1u << kSubBits) - 1);
+        return ((std::uint64_t(1) << kSubBits | sub) + 1) << (exponent - kSubBits);
+    }
+
+    std::array<std::uint64_t, kBuckets> m_counts{};
+    std::uint64_t m_total = 0;
+};
+
+// Swallows render output while measuring.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+struct BenchConfig {
+    unsigned threads = 1;
+    double seconds = 1.0;
+    double readRatio = 0.9;
+    double renderRatio = 0.01;
+};
+
+struct ThreadResult {
+    LatencyHistogram all;
+    std::vector<LatencyHistogram> perOp;
+};
+
+static void runBench(const Variant& variant, const BenchConfig& config) {
+    std::vector<std::size_t> reads, writes, renders;
+    for (std::size_t i = 0; i < variant.ops.size(); ++i) {
+        switch (variant.ops[i].kind) {
+            case OpKind::Read: reads.push_back(i); break;
+            case OpKind::Write: writes.push_back(i); break;
+            case OpKind::Render: renders.push_back(i); break;
+        }
+    }
+
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<ThreadResult> results(config.threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < config.threads; ++t) {
+        results[t].perOp.resize(variant.ops.size());
+        workers.emplace_back([&, t] {
+            std::mt19937 gen(1234u + t); // Fixed seeds keep the op mix identical between runs
+            std::uniform_real_distribution<double> pick(0.0, 1.0);
+            ThreadResult& result = results[t];
+            unsigned counter = t * 7919u;
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            while (!stop.load(std::memory_order_relaxed)) {
+                double roll = pick(gen);
+                const std::vector<std::size_t>* group = &writes;
+                if (!renders.empty() && roll < config.renderRatio) {
+                    group = &renders;
+                } else if (!reads.empty() && (writes.empty() || pick(gen) < config.readRatio)) {
+                    group = &reads;
+                }
+                std::size_t index = (*group)[counter % group->size()];
+                ++counter;
+                auto start = std::chrono::steady_clock::now();
+                variant.ops[index].run(counter);
+                auto ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                         std::chrono::steady_clock::now() - start).count());
+                result.all.record(ns);
+                result.perOp[index].record(ns);
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.seconds));
+    stop.store(true);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ThreadResult total;
+    total.perOp.resize(variant.ops.size());
+    for (const auto& result : results) {
+        total.all.merge(result.all);
+        for (std::size_t i = 0; i < result.perOp.size(); ++i) {
+            total.perOp[i].merge(result.perOp[i]);
+        }
+    }
+
+    std::printf("{\"variant\":\"%s\",\"threads\":%u,\"seconds\":%.3f,\"read_ratio\":%.3f,\"render_ratio\":%.3f,"
+                "\"ops\":%llu,\"ops_per_sec\":%.0f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"per_op\":{",
+                variant.name, config.threads, elapsed, config.readRatio, config.renderRatio,
+                static_cast<unsigned long long>(total.all.count()),
+                static_cast<double>(total.all.count()) / elapsed,
+                static_cast<unsigned long long>(total.all.quantile(0.50)),
+                static_cast<unsigned long long>(total.all.quantile(0.99)),
+                static_cast<unsigned long long>(total.all.quantile(0.999)));
+    bool first = true;
+    for (std::size_t i = 0; i < variant.ops.size(); ++i) {
+        const LatencyHistogram& h = total.perOp[i];
+        if (h.count() == 0) {
+            continue;
+        }
+        std::printf("%s\"%s\":{\"ops\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu}",
+                    first ? "" : ",", variant.ops[i].name, static_cast<unsigned long long>(h.count()),
+                    static_cast<unsigned long long>(h.quantile(0.50)),
+                    static_cast<unsigned long long>(h.quantile(0.99)),
+                    static_cast<unsigned long long>(h.quantile(0.999)));
+        first = false;
+    }
+    std::printf("}}\n");
+    std::fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    BenchConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string value = argv[i + 1];
+        if (flag == "--threads") {
+            maxThreads = static_cast<unsigned>(std::max(1, std::stoi(value)));
+        } else if (flag == "--seconds") {
+            config.seconds = std::stod(value);
+        } else if (flag == "--read-ratio") {
+            config.readRatio = std::stod(value);
+        } else if (flag == "--render-ratio") {
+            config.renderRatio = std::stod(value);
+        } else {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return 1;
+        }
+    }
+
+    setenv("HVAC_HEADLESS", "1", 1); // FrameCompositor output bypasses std::cout
+    NullBuffer sink;
+    std::streambuf* original = std::cout.rdbuf(&sink); // Results go through printf
+    for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        Variant variant = makeBenchVariant(); // Fresh controls per run
+        config.threads = threads;
+        runBench(variant, config);
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+    std::cout.rdbuf(original);
+    return 0;
+}
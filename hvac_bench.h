@@ -0,0 +1,38 @@
+// hvac_bench.h
+#ifndef HVAC_BENCH_H
+#define HVAC_BENCH_H
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Interface between hvac_bench.cpp and the variant it measures.
+//
+// Each variant (check.cpp, .vscode/today*.cpp) is compiled as its own
+// translation unit. Built with -DHVAC_BENCH, it defines makeBenchVariant()
+// in place of main(), so it is linked with the bench's own main() into one
+// binary per variant:
+//
+//   g++ -O2 -std=c++17 -pthread -DHVAC_BENCH hvac_bench.cpp check.cpp -o hvac_bench_check
+//
+// The variant exposes its controls only through the operations below, so
+// the bench never needs to see its classes.
+enum class OpKind { Read, Write, Render };
+
+struct Operation {
+    const char* name;
+    OpKind kind;
+    std::function<void(unsigned)> run; // Argument varies per call so setters change state
+};
+
+// One instance of a variant's controls plus the operations it supports.
+struct Variant {
+    const char* name;
+    std::vector<Operation> ops;
+    std::shared_ptr<void> keepAlive; // Owns the controls and manager
+};
+
+// Defined by the variant's source under HVAC_BENCH. Each call returns fresh
+// controls, so runs don't share state.
+Variant makeBenchVariant();
+
+#endif // HVAC_BENCH_H
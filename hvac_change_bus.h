@@ -0,0 +1,178 @@
+// hvac_change_bus.h
+#ifndef HVAC_CHANGE_BUS_H
+#define HVAC_CHANGE_BUS_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+// Coalescing change-notification bus.
+//
+// Publishers report what changed as a bit mask (the meaning of each bit is
+// up to the application). Each subscriber registers the bits it cares about
+// and accumulates matching changes in one pending mask. A subscriber is woken
+// only by the publish that takes its pending mask from empty to non-empty,
+// and only if it is actually waiting. A burst of changes therefore costs the
+// consumer one wake-up, and that wake-up returns every bit the burst touched.
+// Publishing takes no lock beyond a shared lock on the subscriber list.
+// A subscriber that sleeps elsewhere, such as an event loop, can pass an
+// onPending callback instead of blocking in wait(). The callback runs on
+// the publishing thread at the same empty-to-non-empty transition.
+using ChangeMask = std::uint32_t;
+
+class ChangeBus {
+    struct Slot {
+        ChangeMask interest;
+        std::atomic<ChangeMask> pending{0};
+        std::atomic<bool> waiting{false};
+        std::mutex mutex; // Guards sleeping only; pending is lock-free
+        std::condition_variable wake;
+        std::function<void()> onPending; // Replaces the notify when set
+        Slot(ChangeMask mask, std::function<void()> callback) : interest(mask), onPending(std::move(callback)) {}
+    };
+
+public:
+    static constexpr ChangeMask kAll = ~ChangeMask(0);
+
+    // One consumer's view of the bus. Unsubscribes on destruction. A
+    // subscription is meant to be drained by a single thread.
+    class Subscription {
+    public:
+        Subscription() = default;
+        Subscription(Subscription&&) = default;
+        Subscription& operator=(Subscription&& other) {
+            reset();
+            m_bus = other.m_bus;
+            m_slot = std::move(other.m_slot);
+            other.m_bus = nullptr;
+            return *this;
+        }
+        ~Subscription() { reset(); }
+
+        // Takes and clears everything pending without blocking; 0 if nothing.
+        ChangeMask poll() {
+            return m_slot ? m_slot->pending.exchange(0, std::memory_order_acq_rel) : 0;
+        }
+
+        // Blocks until a change of interest arrives or the bus is closed.
+        // Returns the coalesced mask; 0 means closed.
+        ChangeMask wait() {
+            return waitUntil(std::chrono::steady_clock::time_point::max());
+        }
+
+        // As wait(), but also returns 0 once the timeout passes.
+        template <typename Rep, typename Period>
+        ChangeMask waitFor(std::chrono::duration<Rep, Period> timeout) {
+            return waitUntil(std::chrono::steady_clock::now() + timeout);
+        }
+
+        ChangeMask waitUntil(std::chrono::steady_clock::time_point deadline) {
+            if (!m_slot) {
+                return 0;
+            }
+            Slot& slot = *m_slot;
+            std::unique_lock<std::mutex> lock(slot.mutex);
+            // seq_cst pairs with publish(): either we see its bits here or
+            // it sees waiting == true and notifies under slot.mutex.
+            slot.waiting.store(true);
+            auto ready = [&] { return slot.pending.load() != 0 || m_bus->closed(); };
+            if (deadline == std::chrono::steady_clock::time_point::max()) {
+                slot.wake.wait(lock, ready);
+            } else {
+                slot.wake.wait_until(lock, deadline, ready);
+            }
+            slot.waiting.store(false, std::memory_order_relaxed);
+            return slot.pending.exchange(0, std::memory_order_acq_rel);
+        }
+
+        explicit operator bool() const { return m_slot != nullptr; }
+
+    private:
+        friend class ChangeBus;
+        Subscription(ChangeBus* bus, std::shared_ptr<Slot> slot) : m_bus(bus), m_slot(std::move(slot)) {}
+
+        void reset() {
+            if (m_bus != nullptr && m_slot) {
+                m_bus->unsubscribe(m_slot.get());
+            }
+            m_bus = nullptr;
+            m_slot.reset();
+        }
+
+        ChangeBus* m_bus = nullptr;
+        std::shared_ptr<Slot> m_slot;
+    };
+
+    ChangeBus() = default;
+    ChangeBus(const ChangeBus&) = delete;
+    ChangeBus& operator=(const ChangeBus&) = delete;
+
+    // The returned subscription must not outlive the bus.
+    // onPending, if given, must be cheap and must not (un)subscribe; the
+    // subscriber then collects changes with poll().
+    Subscription subscribe(ChangeMask interest = kAll, std::function<void()> onPending = nullptr) {
+        auto slot = std::make_shared<Slot>(interest, std::move(onPending));
+        std::unique_lock<std::shared_mutex> lock(m_subscribersMutex);
+        m_subscribers.push_back(slot);
+        return Subscription(this, std::move(slot));
+    }
+
+    // Merges changed into every interested subscriber's pending mask.
+    void publish(ChangeMask changed) {
+        std::shared_lock<std::shared_mutex> lock(m_subscribersMutex);
+        for (const auto& slot : m_subscribers) {
+            ChangeMask bits = changed & slot->interest;
+            if (bits == 0) {
+                continue;
+            }
+            // Only the publish that makes the mask non-empty may need to wake;
+            // later ones in the burst just add bits.
+            if (slot->pending.fetch_or(bits) != 0) {
+                continue;
+            }
+            if (slot->onPending) {
+                slot->onPending();
+            } else if (slot->waiting.load()) {
+                std::lock_guard<std::mutex> slotLock(slot->mutex);
+                slot->wake.notify_one();
+            }
+        }
+    }
+
+    // Wakes every waiter; wait() returns 0 from then on once drained.
+    void close() {
+        m_closed.store(true);
+        std::shared_lock<std::shared_mutex> lock(m_subscribersMutex);
+        for (const auto& slot : m_subscribers) {
+            std::lock_guard<std::mutex> slotLock(slot->mutex);
+            slot->wake.notify_all();
+        }
+    }
+
+    bool closed() const { return m_closed.load(); }
+
+    std::size_t subscriberCount() const {
+        std::shared_lock<std::shared_mutex> lock(m_subscribersMutex);
+        return m_subscribers.size();
+    }
+
+private:
+    void unsubscribe(const Slot* slot) {
+        std::unique_lock<std::shared_mutex> lock(m_subscribersMutex);
+        m_subscribers.erase(std::remove_if(m_subscribers.begin(), m_subscribers.end(),
+                                           [slot](const std::shared_ptr<Slot>& s) { return s.get() == slot; }),
+                            m_subscribers.end());
+    }
+
+    mutable std::shared_mutex m_subscribersMutex; // Held exclusively only to (un)subscribe
+    std::vector<std::shared_ptr<Slot>> m_subscribers;
+    std::atomic<bool> m_closed{false};
+};
+
+#endif // HVAC_CHANGE_BUS_H
@@ -0,0 +1,178 @@
+// hvac_control_registry.h
+#ifndef HVAC_CONTROL_REGISTRY_H
+#define HVAC_CONTROL_REGISTRY_H
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Process-wide table mapping control names to small integer ids, so that
+// lookups compare integers instead of freshly built std::strings.
+class NameTable {
+public:
+    using NameId = std::uint32_t;
+    static constexpr NameId kUnknown = 0;
+
+    static NameId intern(const std::string& name) {
+        NameTable& table = instance();
+        std::lock_guard<std::mutex> lock(table.m_mutex);
+        auto it = table.m_ids.find(name);
+        if (it != table.m_ids.end()) {
+            return it->second;
+        }
+        NameId id = static_cast<NameId>(table.m_ids.size() + 1);
+        table.m_ids.emplace(name, id);
+        return id;
+    }
+
+    // Like intern() but never adds; returns kUnknown for names never seen.
+    static NameId find(const std::string& name) {
+        NameTable& table = instance();
+        std::lock_guard<std::mutex> lock(table.m_mutex);
+        auto it = table.m_ids.find(name);
+        return it != table.m_ids.end() ? it->second : kUnknown;
+    }
+
+private:
+    static NameTable& instance() {
+        static NameTable table;
+        return table;
+    }
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, NameId> m_ids;
+};
+
+// Compile-time type key without RTTI: one distinct address per type.
+template <typename T>
+struct ControlTypeKey {
+    static const void* id() {
+        static const char tag = 0;
+        return &tag;
+    }
+};
+
+// Dense control list with O(1) lookup by interned name and by static type.
+// Controls live contiguously for iteration; each is also indexed by name
+// and by the type it was added as. Removal swaps the last control into the
+// freed slot, so iteration order is not preserved across removals.
+// Not internally synchronized; the owning manager's mutex guards it.
+template <typename Base>
+class ControlRegistry {
+public:
+    using NameId = NameTable::NameId;
+
+    template <typename T>
+    void add(std::shared_ptr<T> control, const std::string& name) {
+        Entry entry{std::static_pointer_cast<Base>(control), NameTable::intern(name),
+                    ControlTypeKey<T>::id()};
+        std::uint32_t slot = static_cast<std::uint32_t>(m_controls.size());
+        m_byName[entry.name].push_back(slot);
+        m_byType[entry.type].push_back(slot);
+        m_controls.push_back(entry.control);
+        m_entries.push_back(std::move(entry));
+    }
+
+    // Removes every control registered under name; returns how many.
+    std::size_t remove(const std::string& name) {
+        NameId id = NameTable::find(name);
+        auto it = m_byName.find(id);
+        if (id == NameTable::kUnknown || it == m_byName.end()) {
+            return 0;
+        }
+        std::size_t removed = 0;
+        while (!it->second.empty()) {
+            eraseSlot(it->second.back());
+            ++removed;
+            it = m_byName.find(id);
+            if (it == m_byName.end()) {
+                break;
+            }
+        }
+        return removed;
+    }
+
+    // First control added as T that is still registered, or nullptr.
+    template <typename T>
+    std::shared_ptr<T> get() const {
+        auto it = m_byType.find(ControlTypeKey<T>::id());
+        if (it == m_byType.end() || it->second.empty()) {
+            return nullptr;
+        }
+        // Safe without a dynamic cast: the key records the type it was added as.
+        return std::static_pointer_cast<T>(m_entries[it->second.front()].control);
+    }
+
+    std::shared_ptr<Base> find(const std::string& name) const {
+        auto it = m_byName.find(NameTable::find(name));
+        if (it == m_byName.end() || it->second.empty()) {
+            return nullptr;
+        }
+        return m_entries[it->second.front()].control;
+    }
+
+    const std::vector<std::shared_ptr<Base>>& controls() const { return m_controls; }
+    std::size_t size() const { return m_controls.size(); }
+
+private:
+    struct Entry {
+        std::shared_ptr<Base> control;
+        NameId name;
+        const void* type;
+    };
+
+    static void dropSlot(std::vector<std::uint32_t>& slots, std::uint32_t slot) {
+        for (auto& s : slots) {
+            if (s == slot) {
+                s = slots.back();
+                slots.pop_back();
+                return;
+            }
+        }
+    }
+
+    static void renameSlot(std::vector<std::uint32_t>& slots, std::uint32_t from, std::uint32_t to) {
+        for (auto& s : slots) {
+            if (s == from) {
+                s = to;
+                return;
+            }
+        }
+    }
+
+    // Buckets hold one slot per control with that name or type, normally
+    // just one, so the fix-ups below are constant time in practice.
+    void eraseSlot(std::uint32_t slot) {
+        Entry& victim = m_entries[slot];
+        auto nameIt = m_byName.find(victim.name);
+        dropSlot(nameIt->second, slot);
+        if (nameIt->second.empty()) {
+            m_byName.erase(nameIt);
+        }
+        auto typeIt = m_byType.find(victim.type);
+        dropSlot(typeIt->second, slot);
+        if (typeIt->second.empty()) {
+            m_byType.erase(typeIt);
+        }
+
+        std::uint32_t last = static_cast<std::uint32_t>(m_entries.size() - 1);
+        if (slot != last) {
+            renameSlot(m_byName[m_entries[last].name], last, slot);
+            renameSlot(m_byType[m_entries[last].type], last, slot);
+            m_entries[slot] = std::move(m_entries[last]);
+            m_controls[slot] = std::move(m_controls[last]);
+        }
+        m_entries.pop_back();
+        m_controls.pop_back();
+    }
+
+    std::vector<Entry> m_entries;
+    std::vector<std::shared_ptr<Base>> m_controls; // Parallel to m_entries, for iteration
+    std::unordered_map<NameId, std::vector<std::uint32_t>> m_byName;
+    std::unordered_map<const void*, std::vector<std::uint32_t>> m_byType;
+};
+
+#endif // HVAC_CONTROL_REGISTRY_H
@@ -0,0 +1,542 @@
+// hvac_control_server.h
+#ifndef HVAC_CONTROL_SERVER_H
+#define HVAC_CONTROL_SERVER_H
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Binary control protocol over a Unix domain socket, served from one epoll
+// thread.
+//
+// Every message is a frame: a 2-byte payload length followed by the
+// payload. Requests carry (id:u32, op:u8, value:i32) and responses carry
+// (id:u32, status:u8, temperature:i32, fanLevel:i32, mode:i32). Every
+// response therefore returns the state after the request. Integers are in
+// host byte order, since both ends share the machine.
+//
+// Clients may pipeline: write many requests without waiting, then read the
+// responses, which come back in order. The server parses every complete frame
+// a read delivered, appends all the responses to the connection's output
+// buffer and sends them with one write. EPOLLOUT is armed only while output
+// is backed up. Once a connection has kMaxPendingOutput bytes unsent, the
+// server stops reading from it until the client catches up, so a client
+// that writes without reading cannot grow the server's memory. A client
+// that half-closes still receives every response before the connection
+// closes. Sockets are non-blocking, so one slow client never stalls the
+// others, and a single thread serves thousands of connections.
+// Linux-only; elsewhere the constructors throw.
+
+enum class ControlOp : std::uint8_t {
+    SetTemperature = 1,
+    SetFanLevel = 2,
+    SetMode = 3,
+    GetState = 4,
+};
+
+enum class ControlStatus : std::uint8_t {
+    Ok = 0,
+    BadRequest = 1, // Payload had the wrong size
+    UnknownOp = 2,
+};
+
+struct ControlRequest {
+    std::uint32_t id = 0;
+    ControlOp op = ControlOp::GetState;
+    std::int32_t value = 0;
+};
+
+struct ControlResponse {
+    std::uint32_t id = 0;
+    ControlStatus status = ControlStatus::Ok;
+    std::int32_t temperature = 0;
+    std::int32_t fanLevel = 0;
+    std::int32_t mode = 0;
+};
+
+namespace control_protocol {
+
+constexpr std::size_t kHeaderSize = 2;
+constexpr std::size_t kRequestSize = 9;
+constexpr std::size_t kResponseSize = 17;
+constexpr std::size_t kMaxFrame = 1024; // Larger lengths mean a broken client
+constexpr std::size_t kMaxPendingOutput = 256 * 1024; // Per connection; reading pauses above this
+
+inline void put(std::vector<char>& out, const void* data, std::size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+inline void encodeRequest(std::vector<char>& out, const ControlRequest& request) {
+    std::uint16_t length = kRequestSize;
+    put(out, &length, sizeof(length));
+    put(out, &request.id, sizeof(request.id));
+    put(out, &request.op, sizeof(request.op));
+    put(out, &request.value, sizeof(request.value));
+}
+
+inline void encodeResponse(std::vector<char>& out, const ControlResponse& response) {
+    std::uint16_t length = kResponseSize;
+    put(out, &length, sizeof(length));
+    put(out, &response.id, sizeof(response.id));
+    put(out, &response.status, sizeof(response.status));
+    put(out, &response.temperature, sizeof(response.temperature));
+    put(out, &response.fanLevel, sizeof(response.fanLevel));
+    put(out, &response.mode, sizeof(response.mode));
+}
+
+// Decodes one response payload (without its length prefix).
+inline ControlResponse decodeResponse(const char* payload) {
+    ControlResponse response;
+    std::memcpy(&response.id, payload, 4);
+    std::memcpy(&response.status, payload + 4, 1);
+    std::memcpy(&response.temperature, payload + 5, 4);
+    std::memcpy(&response.fanLevel, payload + 9, 4);
+    std::memcpy(&response.mode, payload + 13, 4);
+    return response;
+}
+
+#if defined(__linux__)
+inline std::runtime_error socketError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+inline sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("socket path too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+#endif
+
+// Raises the soft open-file limit to the hard limit, so one process can hold
+// thousands of connections. Returns the limit now in effect.
+inline std::uint64_t raiseFileLimit() {
+#if defined(__linux__)
+    rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        if (limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+            ::getrlimit(RLIMIT_NOFILE, &limit);
+        }
+        return static_cast<std::uint64_t>(limit.rlim_cur);
+    }
+#endif
+    return 0;
+}
+
+} // namespace control_protocol
+
+class ControlServer {
+public:
+    using Handler = std::function<ControlResponse(const ControlRequest&)>;
+
+    // Binds path (replacing a stale socket file) and starts serving on its
+    // own thread. handler runs on that thread, one request at a time.
+    // Throws std::runtime_error.
+    ControlServer(std::string path, Handler handler) : m_path(std::move(path)), m_handler(std::move(handler)) {
+#if defined(__linux__)
+        control_protocol::raiseFileLimit();
+        sockaddr_un address = control_protocol::socketAddress(m_path);
+        m_listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_listenFd < 0) {
+            throw control_protocol::socketError("cannot create socket for", m_path);
+        }
+        ::unlink(m_path.c_str());
+        if (::bind(m_listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(m_listenFd, SOMAXCONN) != 0) {
+            int error = errno;
+            ::close(m_listenFd);
+            errno = error;
+            throw control_protocol::socketError("cannot listen on", m_path);
+        }
+        m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        m_stopFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_epollFd < 0 || m_stopFd < 0) {
+            closeAll();
+            throw control_protocol::socketError("cannot set up epoll for", m_path);
+        }
+        watch(m_listenFd, EPOLLIN);
+        watch(m_stopFd, EPOLLIN);
+        m_thread = std::thread([this] { run(); });
+#else
+        throw std::runtime_error("the control server requires Linux (epoll)");
+#endif
+    }
+
+    // Stops the loop, closes every connection and removes the socket file.
+    ~ControlServer() {
+#if defined(__linux__)
+        std::uint64_t one = 1;
+        ssize_t written = ::write(m_stopFd, &one, sizeof(one));
+        static_cast<void>(written);
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        closeAll();
+        ::unlink(m_path.c_str());
+#endif
+    }
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    const std::string& path() const { return m_path; }
+    std::uint64_t requestsServed() const { return m_requests.load(std::memory_order_relaxed); }
+    std::uint64_t connectionsAccepted() const { return m_accepted.load(std::memory_order_relaxed); }
+
+private:
+#if defined(__linux__)
+    struct Connection {
+        std::vector<char> input;
+        std::vector<char> output;
+        std::size_t outputSent = 0;
+        std::uint32_t events = EPOLLIN | EPOLLRDHUP; // Current epoll interest
+        bool peerClosed = false; // Read side reached EOF
+        bool inputBacklog = false; // Complete frames left unanswered at the output cap
+
+        std::size_t pendingOutput() const { return output.size() - outputSent; }
+    };
+
+    void watch(int fd, std::uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    void run() {
+        std::vector<epoll_event> events(256);
+        for (;;) {
+            int ready = ::epoll_wait(m_epollFd, events.data(), static_cast<int>(events.size()), -1);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            for (int i = 0; i < ready; ++i) {
+                int fd = events[static_cast<std::size_t>(i)].data.fd;
+                std::uint32_t flags = events[static_cast<std::size_t>(i)].events;
+                if (fd == m_stopFd) {
+                    return;
+                }
+                if (fd == m_listenFd) {
+                    acceptAll();
+                    continue;
+                }
+                auto it = m_connections.find(fd);
+                if (it == m_connections.end()) {
+                    continue;
+                }
+                if ((flags & EPOLLERR) || !serviceConnection(fd, it->second)) {
+                    closeConnection(fd);
+                }
+            }
+        }
+    }
+
+    void acceptAll() {
+        for (;;) {
+            int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return; // EAGAIN: backlog drained (or out of descriptors; retried on the next event)
+            }
+            m_connections.emplace(fd, Connection{});
+            watch(fd, EPOLLIN | EPOLLRDHUP);
+            m_accepted.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Reads, answers and sends until the connection has nothing left to do
+    // now, then sets the epoll interest for what it waits on next. Returns
+    // false when the connection should close: broken, malformed, or
+    // half-closed by the peer with every response sent.
+    bool serviceConnection(int fd, Connection& connection) {
+        do {
+            if (!readRequests(fd, connection) || !flushOutput(fd, connection)) {
+                return false;
+            }
+        } while (connection.inputBacklog && connection.pendingOutput() == 0);
+        if (connection.peerClosed && connection.pendingOutput() == 0) {
+            return false;
+        }
+        std::uint32_t events = connection.pendingOutput() > 0 ? EPOLLOUT : 0u;
+        if (!connection.peerClosed && connection.pendingOutput() < control_protocol::kMaxPendingOutput) {
+            events |= EPOLLIN | EPOLLRDHUP;
+        }
+        if (events != connection.events) {
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = fd;
+            ::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event);
+            connection.events = events;
+        }
+        return true;
+    }
+
+    // Answers buffered frames, then reads and answers more until the socket
+    // is drained, the peer closes, or the output cap is reached. Returns
+    // false on a read error or a malformed frame.
+    bool readRequests(int fd, Connection& connection) {
+        if (!answerFrames(connection)) {
+            return false;
+        }
+        char buffer[16384];
+        while (!connection.peerClosed && connection.pendingOutput() < control_protocol::kMaxPendingOutput) {
+            ssize_t got = ::read(fd, buffer, sizeof(buffer));
+            if (got > 0) {
+                connection.input.insert(connection.input.end(), buffer, buffer + got);
+                if (!answerFrames(connection)) {
+                    return false;
+                }
+                if (static_cast<std::size_t>(got) < sizeof(buffer)) {
+                    break; // Drained; level-triggered epoll reports anything that arrives later
+                }
+                continue;
+            }
+            if (got == 0) {
+                connection.peerClosed = true; // Answer what arrived, send it, then close
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN;
+        }
+        return true;
+    }
+
+    // Answers complete frames in input until the output cap is reached.
+    bool answerFrames(Connection& connection) {
+        std::size_t offset = 0;
+        const std::vector<char>& input = connection.input;
+        connection.inputBacklog = false;
+        while (input.size() - offset >= control_protocol::kHeaderSize) {
+            if (connection.pendingOutput() >= control_protocol::kMaxPendingOutput) {
+                connection.inputBacklog = true;
+                break;
+            }
+            std::uint16_t length;
+            std::memcpy(&length, input.data() + offset, sizeof(length));
+            if (length > control_protocol::kMaxFrame) {
+                return false;
+            }
+            if (input.size() - offset < control_protocol::kHeaderSize + length) {
+                break; // Partial frame; wait for the rest
+            }
+            const char* payload = input.data() + offset + control_protocol::kHeaderSize;
+            control_protocol::encodeResponse(connection.output, dispatch(payload, length));
+            offset += control_protocol::kHeaderSize + length;
+        }
+        connection.input.erase(connection.input.begin(), connection.input.begin() + static_cast<std::ptrdiff_t>(offset));
+        return true;
+    }
+
+    ControlResponse dispatch(const char* payload, std::uint16_t length) {
+        m_requests.fetch_add(1, std::memory_order_relaxed);
+        ControlRequest request;
+        if (length >= 4) {
+            std::memcpy(&request.id, payload, 4);
+        }
+        if (length != control_protocol::kRequestSize) {
+            ControlResponse response = m_handler(ControlRequest{request.id, ControlOp::GetState, 0});
+            response.status = ControlStatus::BadRequest;
+            return response;
+        }
+        std::memcpy(&request.op, payload + 4, 1);
+        std::memcpy(&request.value, payload + 5, 4);
+        if (request.op < ControlOp::SetTemperature || request.op > ControlOp::GetState) {
+            ControlResponse response = m_handler(ControlRequest{request.id, ControlOp::GetState, 0});
+            response.status = ControlStatus::UnknownOp;
+            return response;
+        }
+        ControlResponse response = m_handler(request);
+        response.id = request.id;
+        return response;
+    }
+
+    // Writes as much buffered output as the socket takes; the caller arms
+    // EPOLLOUT for the rest. Returns false if the connection is broken.
+    bool flushOutput(int fd, Connection& connection) {
+        while (connection.outputSent < connection.output.size()) {
+            ssize_t sent = ::send(fd, connection.output.data() + connection.outputSent,
+                                  connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+            if (sent > 0) {
+                connection.outputSent += static_cast<std::size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent < 0 && errno == EAGAIN) {
+                if (connection.outputSent >= control_protocol::kMaxPendingOutput) { // Drop the sent prefix
+                    connection.output.erase(connection.output.begin(),
+                                            connection.output.begin() + static_cast<std::ptrdiff_t>(connection.outputSent));
+                    connection.outputSent = 0;
+                }
+                return true;
+            }
+            return false;
+        }
+        connection.output.clear();
+        connection.outputSent = 0;
+        return true;
+    }
+
+    void closeConnection(int fd) {
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        m_connections.erase(fd);
+    }
+
+    void closeAll() {
+        for (auto& entry : m_connections) {
+            ::close(entry.first);
+        }
+        m_connections.clear();
+        for (int* fd : {&m_listenFd, &m_epollFd, &m_stopFd}) {
+            if (*fd >= 0) {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+
+    int m_listenFd = -1;
+    int m_epollFd = -1;
+    int m_stopFd = -1;
+    std::unordered_map<int, Connection> m_connections; // Server thread only
+    std::thread m_thread;
+#endif
+
+    std::string m_path;
+    Handler m_handler;
+    std::atomic<std::uint64_t> m_requests{0};
+    std::atomic<std::uint64_t> m_accepted{0};
+};
+
+// Blocking client for tools and load generators. Pipelining is explicit:
+// queue() requests, then send() them in one write and receive() the same
+// number of responses.
+class ControlClient {
+public:
+    // Throws std::runtime_error if the server is not reachable.
+    explicit ControlClient(const std::string& path) {
+#if defined(__linux__)
+        sockaddr_un address = control_protocol::socketAddress(path);
+        m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_fd < 0 || ::connect(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            int error = errno;
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+            errno = error;
+            throw control_protocol::socketError("cannot connect to", path);
+        }
+#else
+        static_cast<void>(path);
+        throw std::runtime_error("the control client requires Linux");
+#endif
+    }
+
+    ~ControlClient() {
+#if defined(__linux__)
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+#endif
+    }
+
+    ControlClient(ControlClient&& other) noexcept
+        : m_fd(other.m_fd), m_pending(std::move(other.m_pending)), m_input(std::move(other.m_input)) {
+        other.m_fd = -1;
+    }
+    ControlClient& operator=(ControlClient&&) = delete;
+    ControlClient(const ControlClient&) = delete;
+    ControlClient& operator=(const ControlClient&) = delete;
+
+    void queue(const ControlRequest& request) { control_protocol::encodeRequest(m_pending, request); }
+
+    // Writes every queued request. Throws std::runtime_error on failure.
+    void send() {
+#if defined(__linux__)
+        std::size_t sent = 0;
+        while (sent < m_pending.size()) {
+            ssize_t n = ::send(m_fd, m_pending.data() + sent, m_pending.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                throw std::runtime_error(std::string("control connection lost: ") + std::strerror(errno));
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+#endif
+        m_pending.clear();
+    }
+
+    // Blocks until count responses have arrived; appends them to out in order.
+    void receive(std::size_t count, std::vector<ControlResponse>& out) {
+        const std::size_t frame = control_protocol::kHeaderSize + control_protocol::kResponseSize;
+        std::size_t offset = 0;
+        while (count > 0) {
+            while (m_input.size() - offset >= frame && count > 0) {
+                out.push_back(control_protocol::decodeResponse(m_input.data() + offset + control_protocol::kHeaderSize));
+                offset += frame;
+                --count;
+            }
+            if (count == 0) {
+                break;
+            }
+#if defined(__linux__)
+            char buffer[16384];
+            ssize_t got = ::read(m_fd, buffer, sizeof(buffer));
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                throw std::runtime_error("control connection closed by the server");
+            }
+            m_input.insert(m_input.end(), buffer, buffer + got);
+#endif
+        }
+        m_input.erase(m_input.begin(), m_input.begin() + static_cast<std::ptrdiff_t>(offset));
+    }
+
+    // One request, one round trip.
+    ControlResponse call(const ControlRequest& request) {
+        std::vector<ControlResponse> responses;
+        queue(request);
+        send();
+        receive(1, responses);
+        return responses.front();
+    }
+
+private:
+    int m_fd = -1;
+    std::vector<char> m_pending;
+    std::vector<char> m_input;
+};
+
+#endif // HVAC_CONTROL_SERVER_H
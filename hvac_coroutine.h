@@ -0,0 +1,310 @@
+// hvac_coroutine.h
+#ifndef HVAC_COROUTINE_H
+#define HVAC_COROUTINE_H
+
+// Coroutine runtime for control behaviors: C++20 only. Other builds get
+// HVAC_HAS_COROUTINES == 0 and nothing else, so callers can keep a thread
+// or timer-wheel fallback behind #if HVAC_HAS_COROUTINES.
+#if defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+#define HVAC_HAS_COROUTINES 1
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "hvac_change_bus.h"
+
+// Each behavior is a coroutine (Task) that suspends with
+//     co_await sleepFor(std::chrono::seconds(2));
+//     ChangeMask changed = co_await nextChange(kTemperatureChanged);
+// and an EventLoop resumes it on the loop's thread when the timer fires or
+// a watched ChangeBus publishes a matching change. A suspended behavior is
+// just its coroutine frame (a few hundred bytes), not a thread with its own
+// stack, so one loop thread can host thousands of them. For more cores, run
+// one loop per thread and spread the behaviors across them.
+
+class EventLoop;
+
+// Fire-and-forget coroutine. Nothing runs until it is spawned on a loop; the
+// frame frees itself when the body finishes, or when the loop is destroyed
+// while the task is still suspended.
+class Task {
+public:
+    struct promise_type {
+        EventLoop* loop = nullptr;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); } // A behavior must handle its own errors
+        ~promise_type();
+
+        // Frames are the only per-task memory; track them so it can be reported.
+        static void* operator new(std::size_t size) {
+            liveFrameBytesCounter().fetch_add(size, std::memory_order_relaxed);
+            return ::operator new(size);
+        }
+        static void operator delete(void* frame, std::size_t size) {
+            liveFrameBytesCounter().fetch_sub(size, std::memory_order_relaxed);
+            ::operator delete(frame);
+        }
+    };
+
+    // Bytes held by coroutine frames that have not been freed yet.
+    static std::size_t liveFrameBytes() { return liveFrameBytesCounter().load(std::memory_order_relaxed); }
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    Task& operator=(Task&&) = delete;
+    ~Task() {
+        if (m_handle) {
+            m_handle.destroy(); // Never spawned
+        }
+    }
+
+private:
+    friend class EventLoop;
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    static std::atomic<std::size_t>& liveFrameBytesCounter() {
+        static std::atomic<std::size_t> bytes{0};
+        return bytes;
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    EventLoop() = default;
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Destroys behaviors that are still suspended (timers, change waits).
+    ~EventLoop() {
+        m_subscriptions.clear();
+        destroyPending();
+    }
+
+    // Queues the task to start on the next run() iteration. Loop thread, or
+    // any thread before run() starts.
+    void spawn(Task task) {
+        auto handle = std::exchange(task.m_handle, nullptr);
+        handle.promise().loop = this;
+        ++m_liveTasks;
+        m_ready.push_back(handle);
+    }
+
+    // Routes the bus's changes to nextChange() waiters. The subscription
+    // only flags the loop; matching waiters resume on the loop thread.
+    void watch(ChangeBus& bus, ChangeMask interest = ChangeBus::kAll) {
+        m_subscriptions.push_back(bus.subscribe(interest, [this] { wake(); }));
+    }
+
+    // Runs until stop() is called or every spawned task has finished.
+    void run() {
+        EventLoop* previous = std::exchange(currentLoop(), this);
+        while (!m_stopPending.exchange(false)) {
+            std::deque<std::coroutine_handle<>> batch;
+            batch.swap(m_ready); // Tasks readied while resuming wait for the next pass
+            for (auto handle : batch) {
+                handle.resume();
+                ++m_resumes;
+            }
+            dispatchChanges();
+            collectTimers();
+            if (!m_ready.empty()) {
+                continue;
+            }
+            if (m_liveTasks == 0) {
+                break;
+            }
+            sleepUntilWork();
+        }
+        currentLoop() = previous;
+    }
+
+    // Thread-safe; run() returns after the current pass.
+    void stop() {
+        m_stopPending = true;
+        wake();
+    }
+
+    std::size_t liveTasks() const { return m_liveTasks; }
+    std::uint64_t resumes() const { return m_resumes; }
+
+    // Loop whose run() is executing on this thread, if any.
+    static EventLoop* current() { return currentLoop(); }
+
+    struct SleepAwaiter {
+        EventLoop& loop;
+        Clock::time_point deadline;
+
+        bool await_ready() const { return deadline <= Clock::now(); }
+        void await_suspend(std::coroutine_handle<> handle) {
+            loop.m_timers.push(Timer{deadline, loop.m_nextSequence++, handle});
+        }
+        void await_resume() const {}
+    };
+
+    struct ChangeAwaiter {
+        EventLoop& loop;
+        ChangeMask interest;
+        ChangeMask result = 0;
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            loop.m_changeWaiters.push_back(ChangeWaiter{interest, &result, handle});
+        }
+        ChangeMask await_resume() const { return result; }
+    };
+
+    SleepAwaiter sleepUntil(Clock::time_point deadline) { return SleepAwaiter{*this, deadline}; }
+
+    template <typename Rep, typename Period>
+    SleepAwaiter sleepFor(std::chrono::duration<Rep, Period> duration) {
+        return sleepUntil(Clock::now() + std::chrono::duration_cast<Clock::duration>(duration));
+    }
+
+    // Resumes with the changed bits (intersected with interest) of the
+    // next matching publish on a watched bus.
+    ChangeAwaiter nextChange(ChangeMask interest = ChangeBus::kAll) { return ChangeAwaiter{*this, interest}; }
+
+private:
+    friend struct Task::promise_type;
+
+    struct Timer {
+        Clock::time_point deadline;
+        std::uint64_t sequence; // Equal deadlines resume in suspension order
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    struct ChangeWaiter {
+        ChangeMask interest;
+        ChangeMask* result;
+        std::coroutine_handle<> handle;
+    };
+
+    static EventLoop*& currentLoop() {
+        thread_local EventLoop* loop = nullptr;
+        return loop;
+    }
+
+    void wake() {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        if (!m_woken) {
+            m_woken = true;
+            m_wakeCondition.notify_one();
+        }
+    }
+
+    void dispatchChanges() {
+        ChangeMask changed = 0;
+        for (auto& subscription : m_subscriptions) {
+            changed |= subscription.poll();
+        }
+        if (changed == 0 || m_changeWaiters.empty()) {
+            return;
+        }
+        std::size_t kept = 0;
+        for (const ChangeWaiter& waiter : m_changeWaiters) {
+            if (ChangeMask bits = changed & waiter.interest) {
+                *waiter.result = bits;
+                m_ready.push_back(waiter.handle);
+            } else {
+                m_changeWaiters[kept++] = waiter;
+            }
+        }
+        m_changeWaiters.resize(kept);
+    }
+
+    void collectTimers() {
+        Clock::time_point now = Clock::now();
+        while (!m_timers.empty() && m_timers.top().deadline <= now) {
+            m_ready.push_back(m_timers.top().handle);
+            m_timers.pop();
+        }
+    }
+
+    void sleepUntilWork() {
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        auto woken = [this] { return m_woken; };
+        if (m_timers.empty()) {
+            m_wakeCondition.wait(lock, woken);
+        } else {
+            m_wakeCondition.wait_until(lock, m_timers.top().deadline, woken);
+        }
+        m_woken = false;
+    }
+
+    void destroyPending() {
+        // Destroying a frame runs its promise destructor, which only touches
+        // m_liveTasks, so the containers can be drained directly.
+        while (!m_timers.empty()) {
+            auto handle = m_timers.top().handle;
+            m_timers.pop();
+            handle.destroy();
+        }
+        for (const ChangeWaiter& waiter : m_changeWaiters) {
+            waiter.handle.destroy();
+        }
+        m_changeWaiters.clear();
+        for (auto handle : m_ready) {
+            handle.destroy();
+        }
+        m_ready.clear();
+    }
+
+    std::deque<std::coroutine_handle<>> m_ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers;
+    std::vector<ChangeWaiter> m_changeWaiters;
+    std::vector<ChangeBus::Subscription> m_subscriptions;
+    std::uint64_t m_nextSequence = 0;
+    std::size_t m_liveTasks = 0;
+    std::uint64_t m_resumes = 0;
+    std::atomic<bool> m_stopPending{false};
+
+    std::mutex m_wakeMutex; // Guards m_woken
+    std::condition_variable m_wakeCondition;
+    bool m_woken = false;
+};
+
+inline Task::promise_type::~promise_type() {
+    if (loop != nullptr) {
+        --loop->m_liveTasks;
+    }
+}
+
+// Awaitables for the loop running on the current thread. Prefer sleepUntil
+// with an advancing deadline for periodic work: it does not drift.
+inline EventLoop::SleepAwaiter sleepUntil(EventLoop::Clock::time_point deadline) {
+    return EventLoop::current()->sleepUntil(deadline);
+}
+
+template <typename Rep, typename Period>
+EventLoop::SleepAwaiter sleepFor(std::chrono::duration<Rep, Period> duration) {
+    return EventLoop::current()->sleepFor(duration);
+}
+
+inline EventLoop::ChangeAwaiter nextChange(ChangeMask interest = ChangeBus::kAll) {
+    return EventLoop::current()->nextChange(interest);
+}
+
+#else
+#define HVAC_HAS_COROUTINES 0
+#endif
+
+#endif // HVAC_COROUTINE_H
@@ -0,0 +1,216 @@
+// hvac_epoch.h
+#ifndef HVAC_EPOCH_H
+#define HVAC_EPOCH_H
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Epoch-based reclamation for read-mostly data (an RCU-style scheme).
+//
+// Readers pin the current global epoch for the duration of an
+// EpochDomain::Guard. This costs two stores and no lock, and readers never
+// wait for writers. Writers publish a new version and retire the old one with
+// the epoch at which it was unlinked. A retired version is freed once every
+// pinned reader entered after that epoch, so none of them can still hold it.
+//
+// One process-wide domain; each thread takes a reader slot on its first
+// guard and frees it when the thread exits.
+class EpochDomain {
+public:
+    static constexpr std::size_t kMaxReaders = 128; // Threads that may hold guards at once
+
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // Pins the current epoch. Nested guards on one thread are allowed.
+    class Guard {
+    public:
+        Guard() : m_domain(instance()) { m_domain.enter(); }
+        ~Guard() { m_domain.leave(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        EpochDomain& m_domain;
+    };
+
+    // Frees ptr with deleter once no reader can still be using it.
+    void retire(void* ptr, void (*deleter)(void*)) {
+        std::uint64_t epoch = m_epoch.fetch_add(1); // Readers entering from now on can't see ptr
+        std::lock_guard<std::mutex> lock(m_retiredMutex);
+        m_retired.push_back(Retired{epoch, ptr, deleter});
+        collectLocked();
+    }
+
+    // Frees whatever has become safe; returns how many versions are still waiting.
+    std::size_t collect() {
+        std::lock_guard<std::mutex> lock(m_retiredMutex);
+        collectLocked();
+        return m_retired.size();
+    }
+
+    ~EpochDomain() {
+        // Static destruction: no reader threads are left.
+        for (const Retired& retired : m_retired) {
+            retired.deleter(retired.ptr);
+        }
+    }
+
+private:
+    static constexpr std::uint64_t kIdle = 0;
+
+    struct Retired {
+        std::uint64_t epoch;
+        void* ptr;
+        void (*deleter)(void*);
+    };
+
+    struct alignas(64) ReaderSlot { // One cache line each: no false sharing between readers
+        std::atomic<std::uint64_t> pinned{kIdle};
+        std::atomic<bool> claimed{false};
+    };
+
+    struct ThreadState {
+        ReaderSlot* slot = nullptr;
+        unsigned depth = 0;
+        ~ThreadState() {
+            if (slot != nullptr) {
+                slot->claimed.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    EpochDomain() = default;
+
+    static ThreadState& threadState() {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    ReaderSlot* claimSlot() {
+        for (;;) {
+            for (ReaderSlot& slot : m_slots) {
+                bool expected = false;
+                if (!slot.claimed.load(std::memory_order_relaxed) &&
+                    slot.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return &slot;
+                }
+            }
+            std::this_thread::yield(); // More than kMaxReaders live readers; wait for one to exit
+        }
+    }
+
+    void enter() {
+        ThreadState& state = threadState();
+        if (state.depth++ > 0) {
+            return; // Already pinned by an outer guard
+        }
+        if (state.slot == nullptr) {
+            state.slot = claimSlot();
+        }
+        // seq_cst store: a writer that scans slots after unlinking a version
+        // either sees this pin or we see its new version. Epochs start at 1,
+        // so a pin is never kIdle.
+        state.slot->pinned.store(m_epoch.load());
+    }
+
+    void leave() {
+        ThreadState& state = threadState();
+        if (--state.depth == 0) {
+            state.slot->pinned.store(kIdle, std::memory_order_release);
+        }
+    }
+
+    void collectLocked() {
+        std::uint64_t oldest = ~std::uint64_t(0);
+        for (const ReaderSlot& slot : m_slots) {
+            std::uint64_t pinned = slot.pinned.load();
+            if (pinned != kIdle && pinned < oldest) {
+                oldest = pinned;
+            }
+        }
+        // Safe once every pinned reader entered after the retire epoch.
+        std::size_t kept = 0;
+        for (const Retired& retired : m_retired) {
+            if (retired.epoch < oldest) {
+                retired.deleter(retired.ptr);
+            } else {
+                m_retired[kept++] = retired;
+            }
+        }
+        m_retired.resize(kept);
+    }
+
+    std::atomic<std::uint64_t> m_epoch{1};
+    std::array<ReaderSlot, kMaxReaders> m_slots{};
+    std::mutex m_retiredMutex;
+    std::vector<Retired> m_retired;
+};
+
+// An immutable T published through the epoch domain. read() returns a view
+// that stays valid, and unchanged, for as long as it lives. update() copies
+// the current value, applies the change, publishes the copy and retires the
+// old version. Writers are serialized; readers never block and never block
+// writers.
+template <typename T>
+class EpochProtected {
+public:
+    // Pins the epoch and the version current at the time of read().
+    class ReadView {
+    public:
+        const T& operator*() const { return *m_value; }
+        const T* operator->() const { return m_value; }
+
+    private:
+        friend class EpochProtected;
+        explicit ReadView(const std::atomic<const T*>& current) : m_value(current.load()) {}
+
+        EpochDomain::Guard m_guard; // Declared first: pinned before the load above
+        const T* m_value;
+    };
+
+    explicit EpochProtected(T initial = T{}) : m_current(new T(std::move(initial))) {}
+
+    ~EpochProtected() { delete m_current.load(); } // Owner guarantees no readers remain
+
+    EpochProtected(const EpochProtected&) = delete;
+    EpochProtected& operator=(const EpochProtected&) = delete;
+
+    ReadView read() const { return ReadView(m_current); }
+
+    // mutate(T&) edits a private copy, which is published when it returns
+    // (nothing is published if it throws). Returns what mutate returned.
+    template <typename Mutator>
+    auto update(Mutator&& mutate) {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        std::unique_ptr<T> next(new T(*m_current.load()));
+        if constexpr (std::is_void_v<decltype(mutate(*next))>) {
+            mutate(*next);
+            publish(std::move(next));
+        } else {
+            auto result = mutate(*next);
+            publish(std::move(next));
+            return result;
+        }
+    }
+
+private:
+    void publish(std::unique_ptr<T> next) {
+        const T* old = m_current.exchange(next.release());
+        EpochDomain::instance().retire(const_cast<T*>(old), [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    std::atomic<const T*> m_current;
+    std::mutex m_writerMutex;
+};
+
+#endif // HVAC_EPOCH_H
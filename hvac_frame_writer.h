@@ -0,0 +1,195 @@
+// hvac_frame_writer.h
+#ifndef HVAC_FRAME_WRITER_H
+#define HVAC_FRAME_WRITER_H
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Full-screen frame compositor for the console dashboards.
+//
+// A frame is rendered into a reusable in-memory buffer through begin().
+// present() compares it row by row with the previous frame and emits only
+// the changed part of each changed row, positioned with ANSI cursor moves,
+// in a single write(2). That replaces clearing the screen (or forking
+// system("clear")) and flushing after every line.
+//
+// In headless mode frames are still composed, so render code runs as
+// usual, but nothing is written. Headless is selected explicitly or by
+// setting the HVAC_HEADLESS environment variable.
+class FrameCompositor {
+public:
+    enum class Output { Terminal, Headless };
+
+    static Output defaultOutput() {
+        return std::getenv("HVAC_HEADLESS") != nullptr ? Output::Headless : Output::Terminal;
+    }
+
+    explicit FrameCompositor(Output output = defaultOutput()) : m_output(output), m_stream(&m_sink) {}
+
+    FrameCompositor(const FrameCompositor&) = delete;
+    FrameCompositor& operator=(const FrameCompositor&) = delete;
+
+    // Starts a new frame; write the whole screen to the returned stream.
+    std::ostream& begin() {
+        m_sink.text.clear(); // Keeps capacity, so steady-state frames don't allocate
+        m_stream.clear();
+        return m_stream;
+    }
+
+    // Diffs against the previous frame and writes the changes. Returns the
+    // number of bytes emitted (0 when headless or nothing changed).
+    std::size_t present() {
+        ++m_frames;
+        if (m_output == Output::Headless) {
+            return 0;
+        }
+
+        splitRows(m_sink.text, m_rows);
+        m_out.clear();
+        if (m_firstFrame) {
+            m_out += "\033[2J"; // Clear once; later frames only patch cells
+            m_firstFrame = false;
+        }
+        for (std::size_t row = 0; row < m_rows.size(); ++row) {
+            const std::string& next = m_rows[row];
+            const std::string* prev = row < m_previous.size() ? &m_previous[row] : nullptr;
+            if (prev != nullptr && *prev == next) {
+                continue;
+            }
+            std::size_t common = 0;
+            if (prev != nullptr) {
+                while (common < next.size() && common < prev->size() && next[common] == (*prev)[common]) {
+                    ++common;
+                }
+                while (common > 0 && isContinuationByte(next[common])) {
+                    --common; // Restart at the beginning of a UTF-8 sequence
+                }
+            }
+            moveTo(row, columns(next, common));
+            m_out.append(next, common, std::string::npos);
+            if (prev != nullptr && columns(*prev, prev->size()) > columns(next, next.size())) {
+                m_out += "\033[K"; // Erase leftovers of a longer previous row
+            }
+        }
+        for (std::size_t row = m_rows.size(); row < m_previous.size(); ++row) {
+            moveTo(row, 0);
+            m_out += "\033[K";
+        }
+        m_previous.swap(m_rows);
+        if (m_out.empty()) {
+            return 0; // Nothing changed; skip the cursor park and the write
+        }
+        moveTo(m_previous.size(), 0); // Park the cursor below the frame
+        writeAll(m_out);
+        return m_out.size();
+    }
+
+    // Forces the next present() to repaint everything, e.g. after other
+    // output scrolled the terminal.
+    void invalidate() {
+        m_previous.clear();
+        m_firstFrame = true;
+    }
+
+    std::size_t frames() const { return m_frames; }
+    bool headless() const { return m_output == Output::Headless; }
+
+private:
+    // streambuf over a std::string that is reused between frames.
+    class StringSink : public std::streambuf {
+    public:
+        std::string text;
+
+    protected:
+        int overflow(int c) override {
+            if (c != traits_type::eof()) {
+                text.push_back(static_cast<char>(c));
+            }
+            return c;
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override {
+            text.append(s, static_cast<std::size_t>(n));
+            return n;
+        }
+    };
+
+    static bool isContinuationByte(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+    }
+
+    // Terminal columns taken by the first bytes of row (one per code point).
+    static std::size_t columns(const std::string& row, std::size_t bytes) {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < bytes; ++i) {
+            if (!isContinuationByte(row[i])) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    static void splitRows(const std::string& text, std::vector<std::string>& rows) {
+        std::size_t row = 0;
+        std::size_t start = 0;
+        while (start < text.size()) {
+            std::size_t end = text.find('\n', start);
+            if (end == std::string::npos) {
+                end = text.size();
+            }
+            if (row == rows.size()) {
+                rows.emplace_back();
+            }
+            rows[row++].assign(text, start, end - start);
+            start = end + 1;
+        }
+        rows.resize(row);
+    }
+
+    void moveTo(std::size_t row, std::size_t column) {
+        char move[32];
+        int len = std::snprintf(move, sizeof(move), "\033[%zu;%zuH", row + 1, column + 1);
+        m_out.append(move, static_cast<std::size_t>(len));
+    }
+
+    static void writeAll(const std::string& bytes) {
+        std::fflush(stdout); // Keep ordering with anything buffered through stdio/cout
+#ifndef _WIN32
+        const char* data = bytes.data();
+        std::size_t left = bytes.size();
+        while (left > 0) {
+            ssize_t written = ::write(STDOUT_FILENO, data, left);
+            if (written < 0 && errno == EINTR) {
+                continue; // Interrupted by a signal before anything was written
+            }
+            if (written <= 0) {
+                return; // Console gone; drop the frame
+            }
+            data += written;
+            left -= static_cast<std::size_t>(written);
+        }
+#else
+        std::fwrite(bytes.data(), 1, bytes.size(), stdout);
+        std::fflush(stdout);
+#endif
+    }
+
+    Output m_output;
+    StringSink m_sink;
+    std::ostream m_stream;
+    std::vector<std::string> m_rows;
+    std::vector<std::string> m_previous;
+    std::string m_out;
+    std::size_t m_frames = 0;
+    bool m_firstFrame = true;
+};
+
+#endif // HVAC_FRAME_WRITER_H
@@ -0,0 +1,239 @@
+// hvac_input_trace.h
+#ifndef HVAC_INPUT_TRACE_H
+#define HVAC_INPUT_TRACE_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Record and replay of control inputs.
+//
+// An InputRecorder captures each setTemperature / setFanLevel / setMode call
+// (the requested value, before validation) as a 16-byte record with a
+// nanosecond timestamp. replayTrace() feeds a loaded trace back to a sink
+// at 1x, at Nx, or as fast as possible. The same trace can therefore
+// reproduce a run whose inputs came from random numbers and thread timing,
+// serve as a regression input, or benchmark the control path with a real
+// production trace.
+//
+// File layout: a 32-byte header ("HVACINP1", version, record size, the run's
+// seed, wall-clock start) followed by InputEvent records in call order.
+// Records are buffered and written in blocks, so recording costs a mutex and
+// an array store per call. Integers are host byte order; traces are meant
+// to be replayed on the machine type that recorded them.
+
+enum class InputKind : std::uint8_t {
+    Temperature = 1,
+    FanLevel = 2,
+    Mode = 3,
+};
+
+struct InputEvent {
+    std::int64_t timestampNs; // Caller's monotonic clock; only differences matter
+    std::int32_t value;
+    InputKind kind;
+    std::uint8_t reserved[3];
+};
+static_assert(sizeof(InputEvent) == 16, "InputEvent must stay 16 bytes");
+
+namespace input_trace_detail {
+
+constexpr char kMagic[8] = {'H', 'V', 'A', 'C', 'I', 'N', 'P', '1'};
+constexpr std::uint32_t kVersion = 1;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint64_t seed;
+    std::int64_t startWallNs;
+};
+static_assert(sizeof(FileHeader) == 32, "FileHeader must stay 32 bytes");
+
+inline std::int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace input_trace_detail
+
+class InputRecorder {
+public:
+    static constexpr std::size_t kBufferedEvents = 4096; // One write per 64 KiB
+
+    // Truncates path. seed is stored for reference (e.g. the run's HVAC_SEED).
+    // Throws std::runtime_error.
+    explicit InputRecorder(const std::string& path, std::uint64_t seed = 0)
+        : m_path(path), m_out(path, std::ios::binary | std::ios::trunc) {
+        if (!m_out) {
+            throw std::runtime_error("cannot create input trace " + path);
+        }
+        input_trace_detail::FileHeader header{};
+        std::memcpy(header.magic, input_trace_detail::kMagic, sizeof(header.magic));
+        header.version = input_trace_detail::kVersion;
+        header.recordSize = sizeof(InputEvent);
+        header.seed = seed;
+        header.startWallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        m_out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_buffer.reserve(kBufferedEvents);
+    }
+
+    ~InputRecorder() {
+        try {
+            flush();
+        } catch (...) {
+            // Destructors must not throw; call flush() to see write errors
+        }
+    }
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    // Thread-safe. Records keep the order in which calls reach the recorder.
+    void record(InputKind kind, int value, std::int64_t timestampNs) {
+        InputEvent event{};
+        event.timestampNs = timestampNs;
+        event.value = value;
+        event.kind = kind;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffer.push_back(event);
+        ++m_recorded;
+        if (m_buffer.size() == kBufferedEvents) {
+            writeBufferLocked();
+        }
+    }
+
+    // As above, stamped with steady_clock.
+    void record(InputKind kind, int value) {
+        record(kind, value, input_trace_detail::steadyNowNs());
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        writeBufferLocked();
+        m_out.flush();
+    }
+
+    std::size_t recorded() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_recorded;
+    }
+
+    const std::string& path() const { return m_path; }
+
+private:
+    void writeBufferLocked() {
+        if (m_buffer.empty()) {
+            return;
+        }
+        m_out.write(reinterpret_cast<const char*>(m_buffer.data()),
+                    static_cast<std::streamsize>(m_buffer.size() * sizeof(InputEvent)));
+        m_buffer.clear();
+        if (!m_out) {
+            throw std::runtime_error("cannot write input trace " + m_path);
+        }
+    }
+
+    std::string m_path;
+    std::ofstream m_out;
+    mutable std::mutex m_mutex; // Guards the buffer and the stream
+    std::vector<InputEvent> m_buffer;
+    std::size_t m_recorded = 0;
+};
+
+// A whole trace in memory, ready to replay (any number of times).
+struct InputTrace {
+    std::uint64_t seed = 0;
+    std::int64_t startWallNs = 0;
+    std::vector<InputEvent> events;
+
+    // Throws std::runtime_error on a missing, foreign or truncated file. A
+    // partial trailing record (from a recorder that was killed) is dropped.
+    static InputTrace load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            throw std::runtime_error("cannot open input trace " + path);
+        }
+        const std::streamoff size = in.tellg();
+        in.seekg(0);
+        input_trace_detail::FileHeader header{};
+        if (size < static_cast<std::streamoff>(sizeof(header)) ||
+            !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, input_trace_detail::kMagic, sizeof(header.magic)) != 0 ||
+            header.version != input_trace_detail::kVersion || header.recordSize != sizeof(InputEvent)) {
+            throw std::runtime_error(path + " is not an HVAC input trace");
+        }
+        InputTrace trace;
+        trace.seed = header.seed;
+        trace.startWallNs = header.startWallNs;
+        trace.events.resize(static_cast<std::size_t>(size - static_cast<std::streamoff>(sizeof(header))) /
+                            sizeof(InputEvent));
+        if (!in.read(reinterpret_cast<char*>(trace.events.data()),
+                     static_cast<std::streamsize>(trace.events.size() * sizeof(InputEvent)))) {
+            throw std::runtime_error("cannot read input trace " + path);
+        }
+        return trace;
+    }
+
+    std::chrono::nanoseconds duration() const {
+        return events.empty() ? std::chrono::nanoseconds(0)
+                              : std::chrono::nanoseconds(events.back().timestampNs - events.front().timestampNs);
+    }
+};
+
+struct ReplayStats {
+    std::size_t events = 0;
+    std::chrono::nanoseconds elapsed{0};
+    std::chrono::nanoseconds maxLateness{0}; // Worst delivery behind schedule; 0 at max speed
+};
+
+// Calls sink(const InputEvent&) for each event in order. speed > 0 keeps the
+// recorded spacing scaled by 1/speed (1 = real time), sleeping until each
+// absolute due time so delays never accumulate. speed <= 0 replays as fast
+// as possible. Stops early once keepRunning (if given) turns false.
+template <typename Sink>
+ReplayStats replayTrace(const InputTrace& trace, double speed, Sink&& sink,
+                        const std::atomic<bool>* keepRunning = nullptr) {
+    using Clock = std::chrono::steady_clock;
+    ReplayStats stats;
+    const Clock::time_point start = Clock::now();
+    const std::int64_t origin = trace.events.empty() ? 0 : trace.events.front().timestampNs;
+    for (const InputEvent& event : trace.events) {
+        if (keepRunning != nullptr && !keepRunning->load(std::memory_order_relaxed)) {
+            break;
+        }
+        if (speed > 0) {
+            const auto due = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::nano>(static_cast<double>(event.timestampNs - origin) / speed));
+            std::this_thread::sleep_until(due);
+            stats.maxLateness = std::max(stats.maxLateness,
+                                         std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due));
+        }
+        sink(event);
+        ++stats.events;
+    }
+    stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+    return stats;
+}
+
+// "max" (or "0") means as fast as possible; otherwise a positive multiplier.
+inline double parseReplaySpeed(const std::string& text) {
+    if (text == "max") {
+        return 0.0;
+    }
+    double speed = std::stod(text);
+    if (speed < 0) {
+        throw std::invalid_argument("replay speed must be positive or \"max\"");
+    }
+    return speed;
+}
+
+#endif // HVAC_INPUT_TRACE_H
@@ -0,0 +1,287 @@
+// hvac_periodic.h
+#ifndef HVAC_PERIODIC_H
+#define HVAC_PERIODIC_H
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <cerrno>
+#include <ctime>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+// Fixed-rate control loops on absolute deadlines, with per-loop jitter stats.
+//
+// A loop written as "work; sleep_for(period)" runs at period + work time and
+// drifts a little on every iteration. PeriodicSchedule instead keeps a grid
+// of deadlines start + k * period. Each wake is measured against its
+// deadline: the lateness goes into a log2 histogram, and if whole periods
+// have already passed they are counted as misses and skipped. The loop
+// therefore stays on the grid and never catches up in a burst.
+//
+// PeriodicTimer blocks a thread on that schedule: with timerfd on Linux
+// (armed to the absolute deadline on CLOCK_MONOTONIC, stoppable through an
+// eventfd), and with a condition variable elsewhere. Event loops and timer
+// wheels drive a PeriodicSchedule directly.
+//
+// Every schedule registers its LoopStats by name; LoopStats::reportAll()
+// prints them all, typically at exit.
+
+class LoopStats {
+public:
+    // Registered for reportAll() for the rest of the process; create one
+    // per long-lived loop, not per short task.
+    static std::shared_ptr<LoopStats> create(std::string name, std::chrono::nanoseconds period) {
+        std::shared_ptr<LoopStats> stats(new LoopStats(std::move(name), period));
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registry().push_back(stats);
+        return stats;
+    }
+
+    // One wake, latencyNs after its deadline, after skipping missed periods.
+    void recordWake(std::uint64_t latencyNs, std::uint64_t missed) {
+        m_ticks.fetch_add(1, std::memory_order_relaxed);
+        if (missed > 0) {
+            m_misses.fetch_add(missed, std::memory_order_relaxed);
+        }
+        int bucket = 0;
+        for (std::uint64_t ns = latencyNs; ns != 0 && bucket < kBuckets - 1; ns >>= 1) {
+            ++bucket;
+        }
+        m_latency[static_cast<std::size_t>(bucket)].fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t max = m_maxLatency.load(std::memory_order_relaxed);
+        while (latencyNs > max && !m_maxLatency.compare_exchange_weak(max, latencyNs, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::uint64_t ticks() const { return m_ticks.load(std::memory_order_relaxed); }
+    std::uint64_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+    std::uint64_t maxLatencyNs() const { return m_maxLatency.load(std::memory_order_relaxed); }
+
+    // Upper bound (ns) of the bucket holding the given fraction of wakes.
+    std::uint64_t latencyPercentile(double fraction) const {
+        std::uint64_t total = 0;
+        for (const auto& bucket : m_latency) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        if (total == 0) {
+            return 0;
+        }
+        auto target = static_cast<std::uint64_t>(fraction * static_cast<double>(total));
+        std::uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += m_latency[static_cast<std::size_t>(i)].load(std::memory_order_relaxed);
+            if (seen >= target && seen > 0) {
+                return bucketLimit(i);
+            }
+        }
+        return bucketLimit(kBuckets - 1);
+    }
+
+    // Summary line plus the non-empty histogram buckets.
+    void report(std::ostream& out) const {
+        out << "[loop " << m_name << "] period=" << std::chrono::duration<double, std::milli>(m_period).count()
+            << "ms ticks=" << ticks() << " missed=" << misses()
+            << "\n  wake latency us  p50<=" << static_cast<double>(latencyPercentile(0.50)) / 1000.0
+            << " p99<=" << static_cast<double>(latencyPercentile(0.99)) / 1000.0
+            << " max=" << static_cast<double>(maxLatencyNs()) / 1000.0 << "\n";
+        for (int i = 0; i < kBuckets; ++i) {
+            std::uint64_t count = m_latency[static_cast<std::size_t>(i)].load(std::memory_order_relaxed);
+            if (count > 0) {
+                out << "    <=" << static_cast<double>(bucketLimit(i)) / 1000.0 << "us: " << count << "\n";
+            }
+        }
+    }
+
+    // Prints one block per loop, in creation order.
+    static void reportAll(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (const auto& stats : registry()) {
+            stats->report(out);
+        }
+    }
+
+private:
+    static constexpr int kBuckets = 40; // Bucket i counts latencies in [2^(i-1), 2^i) ns
+
+    LoopStats(std::string name, std::chrono::nanoseconds period) : m_name(std::move(name)), m_period(period) {}
+
+    static std::uint64_t bucketLimit(int bucket) {
+        return bucket == 0 ? 0 : (std::uint64_t(1) << bucket) - 1;
+    }
+
+    static std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::vector<std::shared_ptr<LoopStats>>& registry() {
+        static std::vector<std::shared_ptr<LoopStats>> all;
+        return all;
+    }
+
+    std::string m_name;
+    std::chrono::nanoseconds m_period;
+    std::atomic<std::uint64_t> m_ticks{0};
+    std::atomic<std::uint64_t> m_misses{0};
+    std::atomic<std::uint64_t> m_maxLatency{0};
+    std::array<std::atomic<std::uint64_t>, kBuckets> m_latency{};
+};
+
+// Deadline grid for one loop. Not thread-safe: owned by the loop it paces.
+class PeriodicSchedule {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    PeriodicSchedule(std::string name, Clock::duration period, Clock::time_point start = Clock::now())
+        : m_period(period), m_deadline(start + period), m_stats(LoopStats::create(std::move(name), period)) {}
+
+    // When the loop should next wake.
+    Clock::time_point deadline() const { return m_deadline; }
+    Clock::duration period() const { return m_period; }
+
+    // Call once per wake for deadline(). Records how late it was and moves
+    // to the next deadline on the grid that is still ahead; periods that
+    // passed entirely are counted as misses instead of being run late.
+    void onWake(Clock::time_point now = Clock::now()) {
+        Clock::duration late = now > m_deadline ? now - m_deadline : Clock::duration::zero();
+        auto missed = static_cast<std::uint64_t>(late / m_period);
+        m_deadline += m_period * static_cast<Clock::rep>(missed + 1);
+        m_stats->recordWake(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(late).count()),
+                            missed);
+    }
+
+    const LoopStats& stats() const { return *m_stats; }
+
+private:
+    Clock::duration m_period;
+    Clock::time_point m_deadline;
+    std::shared_ptr<LoopStats> m_stats;
+};
+
+// A thread's fixed-rate loop:
+//     PeriodicTimer timer("temperature", std::chrono::seconds(2));
+//     while (timer.wait()) { ...one step... }
+class PeriodicTimer {
+public:
+    using Clock = PeriodicSchedule::Clock;
+
+    PeriodicTimer(std::string name, Clock::duration period) : m_schedule(std::move(name), period) {
+#if defined(__linux__)
+        m_timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC); // steady_clock's clock on Linux
+        m_stopFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_timerFd < 0 || m_stopFd < 0) {
+            closeFds(); // Fall back to the condition variable
+        }
+#endif
+    }
+
+    ~PeriodicTimer() {
+#if defined(__linux__)
+        closeFds();
+#endif
+    }
+
+    PeriodicTimer(const PeriodicTimer&) = delete;
+    PeriodicTimer& operator=(const PeriodicTimer&) = delete;
+
+    // Blocks until the next deadline; false once stop() has been called.
+    bool wait() {
+        if (m_stopped.load(std::memory_order_acquire)) {
+            return false;
+        }
+#if defined(__linux__)
+        if (m_timerFd >= 0) {
+            return waitTimerFd();
+        }
+#endif
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_stopSignal.wait_until(lock, m_schedule.deadline(),
+                                    [this] { return m_stopped.load(std::memory_order_acquire); })) {
+            return false;
+        }
+        m_schedule.onWake();
+        return true;
+    }
+
+    // Thread-safe; a blocked wait() returns false immediately.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped.store(true, std::memory_order_release);
+        }
+        m_stopSignal.notify_all();
+#if defined(__linux__)
+        if (m_stopFd >= 0) {
+            std::uint64_t one = 1;
+            ssize_t written = ::write(m_stopFd, &one, sizeof(one));
+            static_cast<void>(written); // Only fails if the counter is already set
+        }
+#endif
+    }
+
+    const LoopStats& stats() const { return m_schedule.stats(); }
+
+private:
+#if defined(__linux__)
+    bool waitTimerFd() {
+        auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            m_schedule.deadline().time_since_epoch()).count();
+        itimerspec spec{};
+        spec.it_value.tv_sec = static_cast<time_t>(sinceEpoch / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(sinceEpoch % 1000000000);
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1; // All-zero would disarm the timer
+        }
+        ::timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr); // One shot; the grid lives in m_schedule
+        pollfd fds[2] = {{m_timerFd, POLLIN, 0}, {m_stopFd, POLLIN, 0}};
+        for (;;) {
+            int ready = ::poll(fds, 2, -1);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (m_stopped.load(std::memory_order_acquire) || (fds[1].revents & POLLIN)) {
+                return false;
+            }
+            std::uint64_t expirations = 0;
+            if (::read(m_timerFd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                break;
+            }
+        }
+        m_schedule.onWake();
+        return true;
+    }
+
+    void closeFds() {
+        if (m_timerFd >= 0) {
+            ::close(m_timerFd);
+        }
+        if (m_stopFd >= 0) {
+            ::close(m_stopFd);
+        }
+        m_timerFd = -1;
+        m_stopFd = -1;
+    }
+
+    int m_timerFd = -1;
+    int m_stopFd = -1;
+#endif
+
+    PeriodicSchedule m_schedule;
+    std::atomic<bool> m_stopped{false};
+    std::mutex m_mutex; // Pairs the condition-variable fallback with stop()
+    std::condition_variable m_stopSignal;
+};
+
+#endif // HVAC_PERIODIC_H
@@ -0,0 +1,277 @@
+// hvac_profiled_mutex.h
+#ifndef HVAC_PROFILED_MUTEX_H
+#define HVAC_PROFILED_MUTEX_H
+#include <mutex>
+#include <ostream>
+
+// Drop-in replacement for std::mutex on the shared HVAC locks. Works with
+// std::lock_guard, std::unique_lock and std::scoped_lock.
+//
+// Build with -DHVAC_PROFILE_LOCKS to record, per named lock, acquisition and
+// contention counts, wait-time and hold-time histograms, and which call sites
+// (tagged with HVAC_LOCK_SITE()) had to wait. Without the flag the class is a
+// thin inline forwarder and HVAC_LOCK_SITE() compiles to nothing.
+
+#ifdef HVAC_PROFILE_LOCKS
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Static description of a locking call site; see HVAC_LOCK_SITE().
+struct LockSite {
+    const char* function;
+    int line;
+};
+
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const char* name) : m_name(name) {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registry().push_back(this);
+    }
+
+    ~ProfiledMutex() {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto& all = registry();
+        for (auto it = all.begin(); it != all.end(); ++it) {
+            if (*it == this) {
+                all.erase(it);
+                break;
+            }
+        }
+    }
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock() {
+        if (!enabled()) {
+            m_mutex.lock();
+            return;
+        }
+        if (m_mutex.try_lock()) {
+            onAcquired(0);
+            return;
+        }
+        auto start = Clock::now();
+        m_mutex.lock();
+        auto acquired = Clock::now();
+        m_acquiredAt = acquired;
+        recordAcquire(nanos(acquired - start), true);
+    }
+
+    bool try_lock() {
+        if (!m_mutex.try_lock()) {
+            return false;
+        }
+        if (enabled()) {
+            onAcquired(0);
+        }
+        return true;
+    }
+
+    void unlock() {
+        if (enabled() && m_acquiredAt != Clock::time_point{}) {
+            record(m_hold, nanos(Clock::now() - m_acquiredAt));
+            m_acquiredAt = Clock::time_point{};
+        }
+        m_mutex.unlock();
+    }
+
+    // Runtime switch on top of the compile-time flag; on by default.
+    static void setEnabled(bool on) { enabledFlag().store(on, std::memory_order_relaxed); }
+    static bool enabled() { return enabledFlag().load(std::memory_order_relaxed); }
+
+    // Call site recorded for locks taken on this thread (HVAC_LOCK_SITE()).
+    static const LockSite*& currentSite() {
+        thread_local const LockSite* site = nullptr;
+        return site;
+    }
+
+    // Prints one block per live lock, in registration order.
+    static void reportAll(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (const ProfiledMutex* mutex : registry()) {
+            mutex->report(out);
+        }
+    }
+
+    void report(std::ostream& out) const {
+        std::uint64_t acquisitions = m_acquisitions.load(std::memory_order_relaxed);
+        std::uint64_t contended = m_contended.load(std::memory_order_relaxed);
+        out << "[lock " << m_name << "] acquisitions=" << acquisitions << " contended=" << contended;
+        if (acquisitions > 0) {
+            out << " (" << (100.0 * static_cast<double>(contended) / static_cast<double>(acquisitions)) << "%)";
+        }
+        out << "\n  wait ns  p50<=" << percentile(m_wait, 0.50) << " p99<=" << percentile(m_wait, 0.99)
+            << " max<=" << percentile(m_wait, 1.0)
+            << "\n  hold ns  p50<=" << percentile(m_hold, 0.50) << " p99<=" << percentile(m_hold, 0.99)
+            << " max<=" << percentile(m_hold, 1.0) << "\n";
+        for (const auto& site : m_sites) {
+            const LockSite* key = site.site.load(std::memory_order_acquire);
+            if (key == nullptr) {
+                break;
+            }
+            out << "  contended at " << key->function << ":" << key->line << " x"
+                << site.count.load(std::memory_order_relaxed) << "\n";
+        }
+        if (m_untaggedContention.load(std::memory_order_relaxed) > 0) {
+            out << "  contended at <untagged> x" << m_untaggedContention.load(std::memory_order_relaxed) << "\n";
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int kBuckets = 40; // Bucket i counts samples in [2^(i-1), 2^i) ns
+    static constexpr int kSites = 16;
+    using Histogram = std::array<std::atomic<std::uint64_t>, kBuckets>;
+
+    struct SiteCount {
+        std::atomic<const LockSite*> site{nullptr};
+        std::atomic<std::uint64_t> count{0};
+    };
+
+    static std::uint64_t nanos(Clock::duration d) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        return ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+    }
+
+    static void record(Histogram& histogram, std::uint64_t ns) {
+        int bucket = 0;
+        while (ns != 0 && bucket < kBuckets - 1) {
+            ns >>= 1;
+            ++bucket;
+        }
+        histogram[static_cast<std::size_t>(bucket)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Upper bound of the bucket containing the given fraction of samples.
+    static std::uint64_t percentile(const Histogram& histogram, double fraction) {
+        std::uint64_t total = 0;
+        for (const auto& bucket : histogram) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        if (total == 0) {
+            return 0;
+        }
+        auto target = static_cast<std::uint64_t>(fraction * static_cast<double>(total));
+        std::uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += histogram[static_cast<std::size_t>(i)].load(std::memory_order_relaxed);
+            if (seen >= target && seen > 0) {
+                return i == 0 ? 0 : (std::uint64_t(1) << i) - 1;
+            }
+        }
+        return (std::uint64_t(1) << (kBuckets - 1)) - 1;
+    }
+
+    void onAcquired(std::uint64_t waitNs) {
+        m_acquiredAt = Clock::now();
+        recordAcquire(waitNs, false);
+    }
+
+    void recordAcquire(std::uint64_t waitNs, bool contended) {
+        m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+        record(m_wait, waitNs);
+        if (!contended) {
+            return;
+        }
+        m_contended.fetch_add(1, std::memory_order_relaxed);
+        const LockSite* site = currentSite();
+        if (site == nullptr) {
+            m_untaggedContention.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // Small lock-free table: claim the first empty slot or match the site.
+        for (auto& slot : m_sites) {
+            const LockSite* key = slot.site.load(std::memory_order_acquire);
+            if (key == nullptr) {
+                const LockSite* expected = nullptr;
+                if (slot.site.compare_exchange_strong(expected, site, std::memory_order_acq_rel) ||
+                    expected == site) {
+                    slot.count.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                key = expected;
+            }
+            if (key == site) {
+                slot.count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        m_untaggedContention.fetch_add(1, std::memory_order_relaxed); // Table full
+    }
+
+    static std::atomic<bool>& enabledFlag() {
+        static std::atomic<bool> flag{true};
+        return flag;
+    }
+
+    static std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::vector<ProfiledMutex*>& registry() {
+        static std::vector<ProfiledMutex*> all;
+        return all;
+    }
+
+    std::mutex m_mutex;
+    const char* m_name;
+    Clock::time_point m_acquiredAt{}; // Written and read only by the holder
+    std::atomic<std::uint64_t> m_acquisitions{0};
+    std::atomic<std::uint64_t> m_contended{0};
+    std::atomic<std::uint64_t> m_untaggedContention{0};
+    Histogram m_wait{};
+    Histogram m_hold{};
+    std::array<SiteCount, kSites> m_sites{};
+};
+
+// Tags every ProfiledMutex taken in the current scope with this call site.
+class LockSiteScope {
+public:
+    explicit LockSiteScope(const LockSite* site) : m_previous(ProfiledMutex::currentSite()) {
+        ProfiledMutex::currentSite() = site;
+    }
+    ~LockSiteScope() { ProfiledMutex::currentSite() = m_previous; }
+
+    LockSiteScope(const LockSiteScope&) = delete;
+    LockSiteScope& operator=(const LockSiteScope&) = delete;
+
+private:
+    const LockSite* m_previous;
+};
+
+#define HVAC_LOCK_SITE()                                                       \
+    static const LockSite hvacLockSite_{__func__, __LINE__};                   \
+    LockSiteScope hvacLockSiteScope_(&hvacLockSite_)
+
+#else // !HVAC_PROFILE_LOCKS
+
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const char*) {}
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock() { m_mutex.lock(); }
+    bool try_lock() { return m_mutex.try_lock(); }
+    void unlock() { m_mutex.unlock(); }
+
+    static void setEnabled(bool) {}
+    static bool enabled() { return false; }
+    static void reportAll(std::ostream&) {}
+
+private:
+    std::mutex m_mutex;
+};
+
+#define HVAC_LOCK_SITE() static_cast<void>(0)
+
+#endif // HVAC_PROFILE_LOCKS
+
+#endif // HVAC_PROFILED_MUTEX_H
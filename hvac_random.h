@@ -0,0 +1,165 @@
+// hvac_random.h
+#ifndef HVAC_RANDOM_H
+#define HVAC_RANDOM_H
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <random>
+
+// Small, fast PRNG for simulated sensor noise, jitter and random updates.
+//
+// Xoshiro256pp is xoshiro256++ (Blackman and Vigna): 32 bytes of state, a
+// few adds, shifts and rotates per 64-bit output. Bounded integers use
+// Lemire's multiply-shift method, so the common path has no division and
+// no rejection loop. The fill*() members generate whole arrays in one tight
+// loop instead of one distribution call per value.
+//
+// Streams are reproducible: forStream(seed, id) always yields the same
+// sequence for the same pair, independent of threads or call order, so
+// giving each control its own stream keyed by its id makes simulations
+// repeatable. Set HVAC_SEED to pin processSeed() for a whole run.
+//
+// It also satisfies UniformRandomBitGenerator, so <random> distributions
+// accept it.
+class Xoshiro256pp {
+public:
+    using result_type = std::uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    explicit Xoshiro256pp(std::uint64_t seed = processSeed()) {
+        // SplitMix64 expands the seed so nearby seeds give unrelated states.
+        for (auto& word : m_state) {
+            word = splitMix64(seed);
+        }
+    }
+
+    // Independent, reproducible stream for one control (or zone, sensor...).
+    static Xoshiro256pp forStream(std::uint64_t seed, std::uint64_t streamId) {
+        std::uint64_t mixed = streamId;
+        return Xoshiro256pp(seed ^ splitMix64(mixed));
+    }
+
+    // Seed shared by a run: HVAC_SEED if set, otherwise random once per process.
+    static std::uint64_t processSeed() {
+        static const std::uint64_t seed = [] {
+            if (const char* env = std::getenv("HVAC_SEED")) {
+                return static_cast<std::uint64_t>(std::strtoull(env, nullptr, 10));
+            }
+            std::random_device device;
+            return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+        }();
+        return seed;
+    }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl(m_state[0] + m_state[3], 23) + m_state[0];
+        const std::uint64_t t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound); bound must be non-zero.
+    std::uint32_t below(std::uint32_t bound) {
+        std::uint64_t product = static_cast<std::uint64_t>(next32()) * bound;
+        auto low = static_cast<std::uint32_t>(product);
+        if (low < bound) { // Rare: reject the few values that would bias the result
+            const std::uint32_t threshold = static_cast<std::uint32_t>(-bound) % bound;
+            while (low < threshold) {
+                product = static_cast<std::uint64_t>(next32()) * bound;
+                low = static_cast<std::uint32_t>(product);
+            }
+        }
+        return static_cast<std::uint32_t>(product >> 32);
+    }
+
+    // Uniform in [lo, hi], both inclusive.
+    int range(int lo, int hi) {
+        return lo + static_cast<int>(below(static_cast<std::uint32_t>(hi - lo) + 1u));
+    }
+
+    // Uniform in [0, 1) with full float precision.
+    float unit() {
+        return static_cast<float>((*this)() >> 40) * (1.0f / 16777216.0f);
+    }
+
+    float uniform(float lo, float hi) {
+        return lo + (hi - lo) * unit();
+    }
+
+    // Batch fills. T may be any integer type wide enough for [lo, hi].
+    template <typename T>
+    void fillRange(T* out, std::size_t count, int lo, int hi) {
+        const std::uint32_t span = static_cast<std::uint32_t>(hi - lo) + 1u;
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<T>(lo + static_cast<int>(below(span)));
+        }
+    }
+
+    void fillUniform(float* out, std::size_t count, float lo, float hi) {
+        const float scale = (hi - lo) * (1.0f / 16777216.0f);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = lo + static_cast<float>((*this)() >> 40) * scale;
+        }
+    }
+
+    // Symmetric jitter in [-amplitude, amplitude), e.g. timer or reading jitter.
+    void fillJitter(float* out, std::size_t count, float amplitude) {
+        fillUniform(out, count, -amplitude, amplitude);
+    }
+
+    // Gaussian sensor noise with the given standard deviation (Box-Muller,
+    // two values per pair of draws).
+    void fillGaussian(float* out, std::size_t count, float sigma) {
+        constexpr float kTwoPi = 6.28318530718f;
+        std::size_t i = 0;
+        for (; i + 1 < count; i += 2) {
+            float u1 = 1.0f - unit(); // (0, 1]: keeps log() finite
+            float radius = sigma * std::sqrt(-2.0f * std::log(u1));
+            float angle = kTwoPi * unit();
+            out[i] = radius * std::cos(angle);
+            out[i + 1] = radius * std::sin(angle);
+        }
+        if (i < count) {
+            out[i] = sigma * std::sqrt(-2.0f * std::log(1.0f - unit())) * std::cos(kTwoPi * unit());
+        }
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static std::uint64_t splitMix64(std::uint64_t& state) {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    std::uint32_t next32() {
+        return static_cast<std::uint32_t>((*this)() >> 32);
+    }
+
+    std::uint64_t m_state[4];
+};
+
+// Generator owned by the calling thread, for code with no natural stream id.
+// Each thread gets a distinct stream derived from processSeed().
+// Thread streams count down from ~0 so they never meet small control ids.
+inline Xoshiro256pp& threadRandom() {
+    static std::atomic<std::uint64_t> threadCount{0};
+    thread_local Xoshiro256pp generator =
+        Xoshiro256pp::forStream(Xoshiro256pp::processSeed(), ~threadCount.fetch_add(1));
+    return generator;
+}
+
+#endif // HVAC_RANDOM_H
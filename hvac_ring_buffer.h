@@ -0,0 +1,149 @@
+// hvac_ring_buffer.h
+#ifndef HVAC_RING_BUFFER_H
+#define HVAC_RING_BUFFER_H
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Fixed-capacity single-producer ring used for control history.
+// The writer overwrites the oldest entry once full and never allocates.
+// Readers do not consume: they take a consistent copy of the most recent
+// entries and retry if the writer lapped them during the copy. One spare
+// slot keeps the entry being written disjoint from the N a reader copies.
+template <typename T, std::size_t N>
+class SpscRingBuffer {
+    static_assert(N > 0, "SpscRingBuffer needs a non-zero capacity");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscRingBuffer elements must be trivially copyable");
+
+public:
+    // Stack-allocated copy handed to readers, oldest entry first.
+    struct Snapshot {
+        std::array<T, N> items;
+        std::size_t count = 0;
+
+        const T* begin() const { return items.data(); }
+        const T* end() const { return items.data() + count; }
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const T& back() const { return items[count - 1]; }
+    };
+
+    static constexpr std::size_t capacity() { return N; }
+
+    // Producer side only.
+    void push(const T& value) {
+        std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        // Pairs with the reader's acquire fence: a reader that sees this
+        // slot's new value also sees the head that made it reusable.
+        std::atomic_thread_fence(std::memory_order_release);
+        m_slots[head % kSlots].store(value, std::memory_order_relaxed);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // Producer side only, and only while no reader can be copying, e.g.
+    // before restoring history into a control that is not yet running.
+    void clear() {
+        m_head.store(0, std::memory_order_release);
+    }
+
+    std::size_t size() const {
+        std::uint64_t head = m_head.load(std::memory_order_acquire);
+        return head < N ? static_cast<std::size_t>(head) : N;
+    }
+
+    // Copies the newest entries into out. Slots the writer may have reused
+    // while copying are detected by re-reading the head and retried.
+    void snapshot(Snapshot& out) const {
+        for (;;) {
+            std::uint64_t head = m_head.load(std::memory_order_acquire);
+            std::size_t count = head < N ? static_cast<std::size_t>(head) : N;
+            std::uint64_t first = head - count;
+            for (std::size_t i = 0; i < count; ++i) {
+                out.items[i] = m_slots[(first + i) % kSlots].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            std::uint64_t after = m_head.load(std::memory_order_relaxed);
+            // Index first is only reused by write first + N + 1.
+            if (after - first <= N) {
+                out.count = count;
+                return;
+            }
+        }
+    }
+
+    Snapshot snapshot() const {
+        Snapshot out;
+        snapshot(out);
+        return out;
+    }
+
+private:
+    static constexpr std::size_t kSlots = N + 1;
+
+    alignas(64) std::atomic<std::uint64_t> m_head{0};
+    std::array<std::atomic<T>, kSlots> m_slots{};
+};
+
+// Bounded single-producer, single-consumer FIFO for passing messages between
+// two threads. Unlike SpscRingBuffer nothing is overwritten: tryPush() fails
+// when the queue is full and tryPop() consumes. The producer and consumer
+// indices sit on separate cache lines. Each side also caches the other
+// side's index and re-reads the shared one only when the cache says
+// full/empty, so a busy queue costs about one shared-line transfer per batch
+// rather than per message. N must be a power of two.
+template <typename T, std::size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+    static_assert(std::is_default_constructible<T>::value && std::is_move_assignable<T>::value,
+                  "SpscQueue elements must be default-constructible and move-assignable");
+
+public:
+    static constexpr std::size_t capacity() { return N; }
+
+    // Producer side only.
+    bool tryPush(const T& value) {
+        std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == N) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == N) {
+                return false;
+            }
+        }
+        m_slots[tail & (N - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side only.
+    bool tryPop(T& out) {
+        std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) {
+                return false;
+            }
+        }
+        out = std::move(m_slots[head & (N - 1)]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate unless called from the consumer with the producer idle.
+    std::size_t size() const {
+        return static_cast<std::size_t>(m_tail.load(std::memory_order_acquire) -
+                                        m_head.load(std::memory_order_acquire));
+    }
+
+private:
+    alignas(64) std::atomic<std::uint64_t> m_head{0}; // Next slot to pop; written by the consumer
+    std::uint64_t m_cachedTail = 0; // Consumer's last view of m_tail
+    alignas(64) std::atomic<std::uint64_t> m_tail{0}; // Next slot to fill; written by the producer
+    std::uint64_t m_cachedHead = 0; // Producer's last view of m_head
+    alignas(64) std::array<T, N> m_slots{};
+};
+
+#endif // HVAC_RING_BUFFER_H
@@ -0,0 +1,207 @@
+// hvac_rolling_stats.h
+#ifndef HVAC_ROLLING_STATS_H
+#define HVAC_ROLLING_STATS_H
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <ostream>
+#include <stdexcept>
+
+// Incremental min/max/mean/variance over several trailing time windows of
+// one sample series (e.g. a control's temperature history).
+//
+// add() costs amortized O(1) per window, however long the windows are, and
+// reading a summary is O(1). Nothing rescans the history:
+//  - min and max come from monotonic deques. Each keeps only the samples
+//    that can still become the extreme, so the front is always the answer.
+//  - mean and variance use Welford's update when a sample enters a window
+//    and its inverse when the sample leaves.
+// All windows share one sample queue, sized for the longest window. Each
+// window only tracks where its own oldest sample sits in that queue.
+//
+// Windows advance when samples arrive, so summaries describe the window
+// ending at the latest sample. Statistics are per sample, not time-weighted.
+// Not synchronized: one writer, or publish summaries() through a SeqLock for
+// lock-free readers, as the control screens do.
+struct RollingSummary {
+    std::chrono::nanoseconds span{0};
+    std::uint64_t count = 0;
+    double min = 0;
+    double max = 0;
+    double mean = 0;
+    double variance = 0; // Population variance
+
+    double stddev() const { return std::sqrt(variance); }
+};
+
+class RollingStats {
+public:
+    static constexpr std::size_t kMaxWindows = 4;
+    using Summaries = std::array<RollingSummary, kMaxWindows>; // First windowCount() entries are used
+
+    // Throws std::invalid_argument for no windows, too many, or a zero span.
+    // e.g. RollingStats{std::chrono::minutes(1), std::chrono::hours(1)}.
+    RollingStats(std::initializer_list<std::chrono::nanoseconds> spans) {
+        if (spans.size() == 0 || spans.size() > kMaxWindows) {
+            throw std::invalid_argument("RollingStats needs 1 to 4 windows");
+        }
+        for (std::chrono::nanoseconds span : spans) {
+            if (span.count() <= 0) {
+                throw std::invalid_argument("RollingStats window spans must be positive");
+            }
+            m_windows[m_windowCount++].span = span;
+        }
+    }
+
+    std::size_t windowCount() const { return m_windowCount; }
+
+    // time must not decrease between calls; any epoch works (steady or virtual).
+    void add(std::chrono::nanoseconds time, double value) {
+        const std::uint64_t seq = m_nextSeq++;
+        m_samples.push_back(Sample{time, value});
+        std::uint64_t oldestNeeded = seq;
+        for (std::size_t i = 0; i < m_windowCount; ++i) {
+            Window& window = m_windows[i];
+            window.enter(seq, value);
+            while (sample(window.oldest).time <= time - window.span) {
+                window.leave(window.oldest, sample(window.oldest).value);
+            }
+            oldestNeeded = std::min(oldestNeeded, window.oldest);
+        }
+        while (m_firstSeq < oldestNeeded) { // Drop what even the longest window has passed
+            m_samples.pop_front();
+            ++m_firstSeq;
+        }
+    }
+
+    // Drops every sample; the window spans stay.
+    void clear() {
+        for (std::size_t i = 0; i < m_windowCount; ++i) {
+            std::chrono::nanoseconds span = m_windows[i].span;
+            m_windows[i] = Window{};
+            m_windows[i].span = span;
+        }
+        m_samples.clear();
+        m_firstSeq = m_nextSeq = 0;
+    }
+
+    // fn(time, value) for each sample the longest window still holds, oldest
+    // first; with clear() and add(), this lets a snapshot carry the windows over.
+    template <typename Fn>
+    void forEachSample(Fn fn) const {
+        for (const Sample& sample : m_samples) {
+            fn(sample.time, sample.value);
+        }
+    }
+
+    RollingSummary summary(std::size_t window) const { return m_windows[window].summary(); }
+
+    // Trivially copyable snapshot of every window, for SeqLock publication.
+    Summaries summaries() const {
+        Summaries all{};
+        for (std::size_t i = 0; i < m_windowCount; ++i) {
+            all[i] = m_windows[i].summary();
+        }
+        return all;
+    }
+
+private:
+    struct Sample {
+        std::chrono::nanoseconds time;
+        double value;
+    };
+
+    struct Extreme {
+        std::uint64_t seq;
+        double value;
+    };
+
+    struct Window {
+        std::chrono::nanoseconds span{0};
+        std::uint64_t oldest = 0; // Seq of the oldest sample still inside
+        std::uint64_t count = 0;
+        double mean = 0;
+        double m2 = 0; // Sum of squared deviations (Welford)
+        std::deque<Extreme> minima; // Increasing values; front is the minimum
+        std::deque<Extreme> maxima; // Decreasing values; front is the maximum
+
+        void enter(std::uint64_t seq, double value) {
+            ++count;
+            double delta = value - mean;
+            mean += delta / static_cast<double>(count);
+            m2 += delta * (value - mean);
+            while (!minima.empty() && minima.back().value >= value) {
+                minima.pop_back();
+            }
+            minima.push_back(Extreme{seq, value});
+            while (!maxima.empty() && maxima.back().value <= value) {
+                maxima.pop_back();
+            }
+            maxima.push_back(Extreme{seq, value});
+        }
+
+        void leave(std::uint64_t seq, double value) {
+            ++oldest;
+            if (--count == 0) {
+                mean = 0;
+                m2 = 0;
+            } else {
+                double delta = value - mean;
+                mean -= delta / static_cast<double>(count);
+                m2 = std::max(0.0, m2 - delta * (value - mean)); // Clamp rounding below zero
+            }
+            if (!minima.empty() && minima.front().seq == seq) {
+                minima.pop_front();
+            }
+            if (!maxima.empty() && maxima.front().seq == seq) {
+                maxima.pop_front();
+            }
+        }
+
+        RollingSummary summary() const {
+            RollingSummary result;
+            result.span = span;
+            result.count = count;
+            if (count > 0) {
+                result.min = minima.front().value;
+                result.max = maxima.front().value;
+                result.mean = mean;
+                result.variance = m2 / static_cast<double>(count);
+            }
+            return result;
+        }
+    };
+
+    const Sample& sample(std::uint64_t seq) const { return m_samples[static_cast<std::size_t>(seq - m_firstSeq)]; }
+
+    std::array<Window, kMaxWindows> m_windows{};
+    std::size_t m_windowCount = 0;
+    std::deque<Sample> m_samples; // Seqs m_firstSeq .. m_nextSeq - 1
+    std::uint64_t m_firstSeq = 0;
+    std::uint64_t m_nextSeq = 0;
+};
+
+// One compact line per window, e.g. "1m: 22..28 mean 24.6 sd 1.9 n=30".
+inline void writeRollingSummary(std::ostream& out, const RollingSummary& summary) {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(summary.span).count();
+    if (seconds >= 3600 && seconds % 3600 == 0) {
+        out << seconds / 3600 << "h";
+    } else if (seconds >= 60 && seconds % 60 == 0) {
+        out << seconds / 60 << "m";
+    } else {
+        out << std::chrono::duration<double>(summary.span).count() << "s";
+    }
+    if (summary.count == 0) {
+        out << ": no samples";
+        return;
+    }
+    out << ": " << summary.min << ".." << summary.max << " mean " << summary.mean << " sd " << summary.stddev()
+        << " n=" << summary.count;
+}
+
+#endif // HVAC_ROLLING_STATS_H
@@ -0,0 +1,128 @@
+// hvac_seqlock.h
+#ifndef HVAC_SEQLOCK_H
+#define HVAC_SEQLOCK_H
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <thread>
+
+// Sequence lock for small, trivially copyable values.
+// Writers bump the sequence to an odd value, copy the payload and bump it
+// back to even. Readers never block: they copy the payload and retry if the
+// sequence was odd or changed underneath them (a torn read).
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock() : SeqLock(T{}) {}
+
+    explicit SeqLock(const T& initial) {
+        storeWords(initial);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Lock-free read; spins only while a writer is mid-publish.
+    T load() const {
+        T value;
+        for (;;) {
+            std::uint64_t before = m_sequence.load(std::memory_order_acquire);
+            if (before & 1u) {
+                std::this_thread::yield();
+                continue;
+            }
+            loadWords(value);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == before) {
+                return value;
+            }
+        }
+    }
+
+    // Bounded load for readers that must not spin forever, e.g. on a
+    // segment whose writer died mid-publish. Returns false if every attempt
+    // saw a write in progress or a torn copy.
+    bool tryLoad(T& value, int attempts = 64) const {
+        for (int i = 0; i < attempts; ++i) {
+            std::uint64_t before = m_sequence.load(std::memory_order_acquire);
+            if (before & 1u) {
+                std::this_thread::yield();
+                continue;
+            }
+            loadWords(value);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void store(const T& value) {
+        update([&value](T& current) { current = value; });
+    }
+
+    // Read-modify-write under the writer side. Concurrent writers are
+    // serialized by claiming the odd sequence number with a CAS.
+    template <typename Fn>
+    void update(Fn&& fn) {
+        std::uint64_t seq = beginWrite();
+        T value;
+        loadWords(value);
+        fn(value);
+        storeWords(value);
+        m_sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Number of completed publishes; useful to detect change without a copy.
+    std::uint64_t version() const {
+        return m_sequence.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    static constexpr std::size_t kWords = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    std::uint64_t beginWrite() {
+        std::uint64_t seq = m_sequence.load(std::memory_order_relaxed);
+        for (;;) {
+            if (!(seq & 1u) &&
+                m_sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+                std::atomic_thread_fence(std::memory_order_release);
+                return seq;
+            }
+            if (seq & 1u) {
+                std::this_thread::yield();
+                seq = m_sequence.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // The payload is kept in relaxed atomic words so that a reader racing a
+    // writer is well-defined; the sequence check discards torn copies.
+    void loadWords(T& value) const {
+        std::array<std::uint64_t, kWords> words;
+        for (std::size_t i = 0; i < kWords; ++i) {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T)); // T may have member initializers
+    }
+
+    void storeWords(const T& value) {
+        std::array<std::uint64_t, kWords> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for (std::size_t i = 0; i < kWords; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    alignas(64) std::atomic<std::uint64_t> m_sequence{0};
+    std::array<std::atomic<std::uint64_t>, kWords> m_words{};
+};
+
+#endif // HVAC_SEQLOCK_H
@@ -0,0 +1,208 @@
+// hvac_shard_runtime.h
+#ifndef HVAC_SHARD_RUNTIME_H
+#define HVAC_SHARD_RUNTIME_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "hvac_ring_buffer.h"
+#include "hvac_thread_placement.h"
+
+// Shared-nothing, shard-per-core runtime for fleets of vehicles.
+//
+// Each shard is one thread, optionally pinned to its own CPU, that
+// exclusively owns a State (e.g. a ZoneClimateStore holding thousands of
+// vehicles). Shard code therefore runs single-threaded and takes no locks.
+// Shards never touch each other's State. Work for another shard travels as
+// a Message over a dedicated SpscQueue per (source, target) pair, plus one
+// queue per shard for the external producer. No queue ever has two writers
+// or two readers, and no two shards contend on a cache line except the
+// queue they share.
+//
+// A shard's loop drains its inboxes through onMessage, then calls onPoll
+// for its own work (periodic passes, rendering). It spins briefly and then
+// naps when both are idle. Nothing blocks: if a target's queue is full,
+// send() parks the message in a shard-local backlog, which keeps per-target
+// order and is retried every iteration. Shards cannot deadlock on each
+// other.
+template <typename State, typename Message, std::size_t QueueCapacity = 1024>
+class ShardRuntime {
+    using Queue = SpscQueue<Message, QueueCapacity>;
+
+public:
+    // Counters kept by each shard's own thread; read them after stop().
+    struct ShardStats {
+        std::uint64_t handled = 0; // Messages delivered to onMessage
+        std::uint64_t sent = 0; // Messages this shard sent to shards
+        std::uint64_t deferred = 0; // Sends that had to wait in the backlog
+        std::uint64_t busyPolls = 0; // onPoll calls that did work
+    };
+
+    // Handed to the callbacks; valid only on the shard's own thread.
+    class Context {
+    public:
+        unsigned shard() const { return m_shard; }
+        unsigned shardCount() const { return m_runtime.shardCount(); }
+
+        // Delivers message to target's onMessage (target may be this shard).
+        // Never blocks and never fails.
+        void send(unsigned target, const Message& message) { m_runtime.sendFrom(m_shard, target, message); }
+
+    private:
+        friend class ShardRuntime;
+        Context(ShardRuntime& runtime, unsigned shard) : m_runtime(runtime), m_shard(shard) {}
+
+        ShardRuntime& m_runtime;
+        unsigned m_shard;
+    };
+
+    using MessageHandler = std::function<void(State&, Context&, const Message&)>;
+    using PollHandler = std::function<bool(State&, Context&)>; // Returns true if it did any work
+
+    // One shard per state. Shard i is pinned to CPU i % hardware_concurrency
+    // when pinShards is set.
+    ShardRuntime(std::vector<State> states, MessageHandler onMessage, PollHandler onPoll, bool pinShards = true)
+        : m_onMessage(std::move(onMessage)), m_onPoll(std::move(onPoll)), m_pinShards(pinShards),
+          m_shardCount(static_cast<unsigned>(states.size())),
+          m_queues(new Queue[static_cast<std::size_t>(m_shardCount) * (m_shardCount + 1)]) {
+        m_shards.reserve(m_shardCount);
+        for (auto& state : states) {
+            m_shards.emplace_back(new Shard(std::move(state), m_shardCount));
+        }
+    }
+
+    ~ShardRuntime() { stop(); }
+
+    ShardRuntime(const ShardRuntime&) = delete;
+    ShardRuntime& operator=(const ShardRuntime&) = delete;
+
+    void start() {
+        if (m_running.exchange(true)) {
+            return;
+        }
+        for (unsigned i = 0; i < m_shardCount; ++i) {
+            m_shards[i]->thread = std::thread([this, i] { run(i); });
+        }
+    }
+
+    // Each shard finishes its iteration, drains what is already in its
+    // inboxes and exits. Messages still in a backlog are dropped.
+    void stop() {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+        for (auto& shard : m_shards) {
+            shard->thread.join();
+        }
+    }
+
+    // External producer (one thread, e.g. a gateway). Returns false if that
+    // shard's external inbox is full; retry later.
+    bool post(unsigned shard, const Message& message) { return queue(shard, m_shardCount).tryPush(message); }
+
+    unsigned shardCount() const { return m_shardCount; }
+
+    // Only while the runtime is stopped.
+    State& state(unsigned shard) { return m_shards[shard]->state; }
+    const ShardStats& stats(unsigned shard) const { return m_shards[shard]->stats; }
+
+private:
+    struct Shard {
+        Shard(State initial, unsigned shards) : state(std::move(initial)), backlog(shards) {}
+
+        State state;
+        ShardStats stats;
+        std::vector<std::deque<Message>> backlog; // Per target; non-empty only while its queue is full
+        std::thread thread;
+    };
+
+    // Inbox of target fed by source; source == m_shardCount is the external producer.
+    Queue& queue(unsigned target, unsigned source) {
+        return m_queues[static_cast<std::size_t>(target) * (m_shardCount + 1) + source];
+    }
+
+    void sendFrom(unsigned source, unsigned target, const Message& message) {
+        Shard& shard = *m_shards[source];
+        ++shard.stats.sent;
+        std::deque<Message>& waiting = shard.backlog[target];
+        if (waiting.empty() && queue(target, source).tryPush(message)) {
+            return;
+        }
+        waiting.push_back(message); // Behind anything already waiting, to keep order
+        ++shard.stats.deferred;
+    }
+
+    bool flushBacklog(unsigned source) {
+        bool moved = false;
+        Shard& shard = *m_shards[source];
+        for (unsigned target = 0; target < m_shardCount; ++target) {
+            std::deque<Message>& waiting = shard.backlog[target];
+            while (!waiting.empty() && queue(target, source).tryPush(waiting.front())) {
+                waiting.pop_front();
+                moved = true;
+            }
+        }
+        return moved;
+    }
+
+    // At most one queue's worth per inbox per pass, so onPoll is never starved.
+    bool drainInboxes(unsigned index, Context& context) {
+        Shard& shard = *m_shards[index];
+        bool handled = false;
+        Message message;
+        for (unsigned source = 0; source <= m_shardCount; ++source) {
+            Queue& inbox = queue(index, source);
+            for (std::size_t n = 0; n < QueueCapacity && inbox.tryPop(message); ++n) {
+                m_onMessage(shard.state, context, message);
+                ++shard.stats.handled;
+                handled = true;
+            }
+        }
+        return handled;
+    }
+
+    void run(unsigned index) {
+        if (m_pinShards) {
+            unsigned cpus = std::thread::hardware_concurrency() == 0 ? 1 : std::thread::hardware_concurrency();
+            ThreadPlacement placement;
+            placement.cpu = static_cast<int>(index % cpus);
+            placement.configured = true;
+            applyPlacement(placement, "shard", std::cerr);
+        }
+        Shard& shard = *m_shards[index];
+        Context context(*this, index);
+        unsigned idle = 0;
+        while (m_running.load(std::memory_order_relaxed)) {
+            bool busy = flushBacklog(index);
+            busy = drainInboxes(index, context) || busy;
+            if (m_onPoll(shard.state, context)) {
+                ++shard.stats.busyPolls;
+                busy = true;
+            }
+            if (busy) {
+                idle = 0;
+            } else if (++idle < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100)); // Bounds idle message latency
+            }
+        }
+        drainInboxes(index, context);
+    }
+
+    MessageHandler m_onMessage;
+    PollHandler m_onPoll;
+    bool m_pinShards;
+    unsigned m_shardCount;
+    std::unique_ptr<Queue[]> m_queues;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<bool> m_running{false};
+};
+
+#endif // HVAC_SHARD_RUNTIME_H
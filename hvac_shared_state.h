@@ -0,0 +1,207 @@
+// hvac_shared_state.h
+#ifndef HVAC_SHARED_STATE_H
+#define HVAC_SHARED_STATE_H
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "hvac_seqlock.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Publishes a small state struct through a POSIX shared-memory segment
+// (shm_open), so another process can read it without talking to the
+// control process.
+//
+// The segment holds a header and a SeqLock<T>. Its sequence counter and
+// payload words are lock-free std::atomic<uint64_t>, and those are
+// address-free, so they work across processes. Publishing is the same few
+// stores as the in-process SeqLock and needs no syscall. Readers map the
+// segment read-only, poll at any rate, and can never stall or corrupt the
+// publisher. They use tryLoad(), so a publisher that dies mid-write makes
+// reads fail instead of spinning.
+//
+// T must be trivially copyable and have the same layout in both programs;
+// the header records sizeof(T) and a caller-chosen layout version to catch
+// mismatches. POSIX-only; on _WIN32 both sides throw.
+
+namespace shared_state_detail {
+
+constexpr char kMagic[8] = {'H', 'V', 'A', 'C', 'S', 'H', 'M', '1'};
+
+struct Header {
+    char magic[8];
+    std::uint32_t layoutVersion;
+    std::uint32_t payloadSize;
+    std::int64_t publisherPid;
+    std::atomic<std::uint32_t> open; // Cleared when the publisher shuts down
+    std::atomic<std::uint32_t> ready; // Set last, once the segment is initialized
+};
+
+template <typename T>
+struct Layout {
+    Header header;
+    alignas(64) SeqLock<T> state;
+};
+
+inline std::runtime_error systemError(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+
+} // namespace shared_state_detail
+
+template <typename T>
+class SharedStatePublisher {
+    static_assert(std::is_trivially_copyable<T>::value, "Shared state must be trivially copyable");
+    using Layout = shared_state_detail::Layout<T>;
+
+public:
+    // name is a shm_open name such as "/hvac_state". An existing segment
+    // (e.g. left by a crashed run) is replaced. Throws std::runtime_error.
+    SharedStatePublisher(std::string name, const T& initial, std::uint32_t layoutVersion = 1)
+        : m_name(std::move(name)) {
+#ifndef _WIN32
+        ::shm_unlink(m_name.c_str());
+        int fd = ::shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) {
+            throw shared_state_detail::systemError("cannot create shared memory", m_name);
+        }
+        if (::ftruncate(fd, sizeof(Layout)) != 0) {
+            ::close(fd);
+            ::shm_unlink(m_name.c_str());
+            throw shared_state_detail::systemError("cannot size shared memory", m_name);
+        }
+        void* mapping = ::mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            ::shm_unlink(m_name.c_str());
+            throw shared_state_detail::systemError("cannot map shared memory", m_name);
+        }
+        m_layout = new (mapping) Layout{};
+        std::memcpy(m_layout->header.magic, shared_state_detail::kMagic, sizeof(shared_state_detail::kMagic));
+        m_layout->header.layoutVersion = layoutVersion;
+        m_layout->header.payloadSize = sizeof(T);
+        m_layout->header.publisherPid = static_cast<std::int64_t>(::getpid());
+        m_layout->state.store(initial);
+        m_layout->header.open.store(1, std::memory_order_relaxed);
+        m_layout->header.ready.store(1, std::memory_order_release);
+#else
+        static_cast<void>(initial);
+        static_cast<void>(layoutVersion);
+        throw std::runtime_error("shared-memory state requires a POSIX system");
+#endif
+    }
+
+    // Marks the segment closed for attached readers and removes its name.
+    ~SharedStatePublisher() {
+#ifndef _WIN32
+        if (m_layout != nullptr) {
+            m_layout->header.open.store(0, std::memory_order_release);
+            ::munmap(m_layout, sizeof(Layout));
+            ::shm_unlink(m_name.c_str());
+        }
+#endif
+    }
+
+    SharedStatePublisher(const SharedStatePublisher&) = delete;
+    SharedStatePublisher& operator=(const SharedStatePublisher&) = delete;
+
+    void store(const T& value) { m_layout->state.store(value); }
+
+    template <typename Fn>
+    void update(Fn&& fn) {
+        m_layout->state.update(std::forward<Fn>(fn));
+    }
+
+    const std::string& name() const { return m_name; }
+
+private:
+    std::string m_name;
+    Layout* m_layout = nullptr;
+};
+
+template <typename T>
+class SharedStateReader {
+    static_assert(std::is_trivially_copyable<T>::value, "Shared state must be trivially copyable");
+    using Layout = shared_state_detail::Layout<T>;
+
+public:
+    // Maps an existing segment read-only. Throws std::runtime_error if it
+    // is missing, not initialized yet, or laid out for a different T.
+    explicit SharedStateReader(const std::string& name, std::uint32_t layoutVersion = 1) {
+#ifndef _WIN32
+        int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw shared_state_detail::systemError("cannot open shared memory", name);
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Layout)) {
+            ::close(fd);
+            throw std::runtime_error("shared memory " + name + " is too small for this state layout");
+        }
+        void* mapping = ::mmap(nullptr, sizeof(Layout), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw shared_state_detail::systemError("cannot map shared memory", name);
+        }
+        m_layout = static_cast<const Layout*>(mapping);
+        const shared_state_detail::Header& header = m_layout->header;
+        if (header.ready.load(std::memory_order_acquire) != 1 ||
+            std::memcmp(header.magic, shared_state_detail::kMagic, sizeof(shared_state_detail::kMagic)) != 0 ||
+            header.layoutVersion != layoutVersion || header.payloadSize != sizeof(T)) {
+            ::munmap(mapping, sizeof(Layout));
+            m_layout = nullptr;
+            throw std::runtime_error("shared memory " + name + " has an unexpected layout");
+        }
+#else
+        static_cast<void>(name);
+        static_cast<void>(layoutVersion);
+        throw std::runtime_error("shared-memory state requires a POSIX system");
+#endif
+    }
+
+    ~SharedStateReader() {
+#ifndef _WIN32
+        if (m_layout != nullptr) {
+            ::munmap(const_cast<Layout*>(m_layout), sizeof(Layout));
+        }
+#endif
+    }
+
+    SharedStateReader(const SharedStateReader&) = delete;
+    SharedStateReader& operator=(const SharedStateReader&) = delete;
+
+    // Loads only; safe on the read-only mapping (plain 64-bit atomic loads).
+    bool read(T& value) const { return m_layout->state.tryLoad(value); }
+
+    // Changes whenever the publisher stores; cheap to poll before read().
+    std::uint64_t version() const { return m_layout->state.version(); }
+
+    // False once the publisher has shut down cleanly or its process is gone
+    // (a killed publisher never clears the open flag).
+    bool publisherOpen() const {
+        if (m_layout->header.open.load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+#ifndef _WIN32
+        return ::kill(static_cast<pid_t>(m_layout->header.publisherPid), 0) == 0 || errno == EPERM;
+#else
+        return true;
+#endif
+    }
+    std::int64_t publisherPid() const { return m_layout->header.publisherPid; }
+
+private:
+    const Layout* m_layout = nullptr;
+};
+
+#endif // HVAC_SHARED_STATE_H
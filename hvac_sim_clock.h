@@ -0,0 +1,125 @@
+// hvac_sim_clock.h
+#ifndef HVAC_SIM_CLOCK_H
+#define HVAC_SIM_CLOCK_H
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Injectable time source for simulations. Code that paces itself through a
+// SimClock instead of std::this_thread::sleep_for can run against the wall
+// clock or against virtual time that jumps straight to the next event.
+class SimClock {
+public:
+    using Duration = std::chrono::nanoseconds;
+    using TimePoint = std::chrono::time_point<std::chrono::steady_clock, Duration>;
+
+    virtual ~SimClock() = default;
+    virtual TimePoint now() const = 0;
+    virtual void sleepUntil(TimePoint deadline) = 0;
+};
+
+class RealClock : public SimClock {
+public:
+    TimePoint now() const override {
+        return std::chrono::time_point_cast<Duration>(std::chrono::steady_clock::now());
+    }
+
+    void sleepUntil(TimePoint deadline) override {
+        std::this_thread::sleep_until(deadline);
+    }
+};
+
+// Virtual time: sleeping simply advances now() to the deadline. Single
+// threaded by design; everything paced by it runs on the caller's thread.
+class VirtualClock : public SimClock {
+public:
+    explicit VirtualClock(TimePoint start = TimePoint{}) : m_now(start) {}
+
+    TimePoint now() const override { return m_now; }
+
+    void sleepUntil(TimePoint deadline) override {
+        if (deadline > m_now) {
+            m_now = deadline;
+        }
+    }
+
+private:
+    TimePoint m_now;
+};
+
+// Single-threaded periodic task loop driven by a SimClock. Tasks fire in
+// timestamp order; ties go to the event scheduled first, so a run with a
+// VirtualClock and seeded inputs is fully reproducible.
+class SimulationLoop {
+public:
+    using Task = std::function<void()>;
+
+    explicit SimulationLoop(SimClock& clock) : m_clock(clock) {}
+
+    // First run is one period after the loop's start. Throws
+    // std::invalid_argument for a period that is not positive, which would
+    // keep the loop at the same instant forever.
+    void every(SimClock::Duration period, Task task) {
+        if (period <= SimClock::Duration::zero()) {
+            throw std::invalid_argument("SimulationLoop::every needs a positive period");
+        }
+        m_tasks.push_back(Periodic{period, std::move(task)});
+        std::size_t index = m_tasks.size() - 1;
+        m_queue.push(Event{m_clock.now() + period, m_nextSequence++, index});
+    }
+
+    template <typename Rep, typename Period>
+    void every(std::chrono::duration<Rep, Period> period, Task task) {
+        every(std::chrono::duration_cast<SimClock::Duration>(period), std::move(task));
+    }
+
+    // Runs every event due at or before end, then leaves the clock at end.
+    // Returns the number of task invocations.
+    std::uint64_t runUntil(SimClock::TimePoint end) {
+        std::uint64_t fired = 0;
+        while (!m_queue.empty() && m_queue.top().due <= end) {
+            Event event = m_queue.top();
+            m_queue.pop();
+            m_clock.sleepUntil(event.due);
+            m_tasks[event.task].task();
+            ++fired;
+            // Absolute reschedule: no drift from the task's own run time.
+            m_queue.push(Event{event.due + m_tasks[event.task].period, m_nextSequence++, event.task});
+        }
+        m_clock.sleepUntil(end);
+        return fired;
+    }
+
+    template <typename Rep, typename Period>
+    std::uint64_t runFor(std::chrono::duration<Rep, Period> duration) {
+        return runUntil(m_clock.now() + std::chrono::duration_cast<SimClock::Duration>(duration));
+    }
+
+private:
+    struct Periodic {
+        SimClock::Duration period;
+        Task task;
+    };
+
+    struct Event {
+        SimClock::TimePoint due;
+        std::uint64_t sequence;
+        std::size_t task;
+
+        bool operator>(const Event& other) const {
+            return due != other.due ? due > other.due : sequence > other.sequence;
+        }
+    };
+
+    SimClock& m_clock;
+    std::vector<Periodic> m_tasks;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> m_queue;
+    std::uint64_t m_nextSequence = 0;
+};
+
+#endif // HVAC_SIM_CLOCK_H
@@ -0,0 +1,341 @@
+// hvac_snapshot.h
+#ifndef HVAC_SNAPSHOT_H
+#define HVAC_SNAPSHOT_H
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Versioned binary snapshots of named, trivially copyable sections, for
+// restarting from saved state instead of constructor defaults.
+//
+// File layout: a 64-byte header ("HVACSNP1", format version, section count,
+// file size, FNV-1a checksum of everything after the header), then a table
+// of 64-byte section entries (name, payload version, offset, size), then
+// the payloads, each 64-byte aligned. Each section carries its own payload
+// version. A reader that finds a different version or size gets nullptr
+// and keeps its defaults, so an old snapshot never restores garbage.
+//
+// SnapshotWriter::commit() writes a temporary file next to the target,
+// fsyncs it, renames it over the target and fsyncs the directory. Readers
+// therefore see either the previous snapshot or the new one, never a
+// partial file. SnapshotReader maps the file read-only and hands out
+// pointers straight into the mapping, with no per-field decoding. The
+// checksum pass is the only work proportional to the file size.
+// Integers are host byte order, as in the telemetry log and input traces.
+// POSIX-only; on _WIN32 commit and open throw.
+
+namespace snapshot_detail {
+
+constexpr char kMagic[8] = {'H', 'V', 'A', 'C', 'S', 'N', 'P', '1'};
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr std::size_t kAlignment = 64;
+constexpr std::size_t kNameSize = 40;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t sectionCount;
+    std::uint64_t fileSize;
+    std::uint64_t checksum; // FNV-1a over bytes [sizeof(FileHeader), fileSize)
+    std::int64_t createdWallNs;
+    std::uint8_t reserved[24];
+};
+static_assert(sizeof(FileHeader) == 64, "Snapshot header is 64 bytes on disk");
+
+struct SectionEntry {
+    char name[kNameSize]; // NUL-padded
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t offset; // From the start of the file; a multiple of kAlignment
+    std::uint64_t size;
+};
+static_assert(sizeof(SectionEntry) == 64, "Snapshot section entries are 64 bytes on disk");
+
+inline std::uint64_t fnv1a(const unsigned char* data, std::size_t size) {
+    std::uint64_t hash = 1469598103934665603ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+inline std::size_t alignUp(std::size_t value) {
+    return (value + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+inline std::runtime_error systemError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+} // namespace snapshot_detail
+
+// Read-only view of a section holding an array.
+template <typename T>
+struct SnapshotArray {
+    const T* data = nullptr;
+    std::size_t count = 0;
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+class SnapshotWriter {
+public:
+    // Copies value now; later changes to it are not captured. Names must be
+    // unique and shorter than 40 bytes (std::invalid_argument otherwise).
+    template <typename T>
+    void add(const std::string& name, std::uint32_t version, const T& value) {
+        addArray(name, version, &value, 1);
+    }
+
+    template <typename T>
+    void addArray(const std::string& name, std::uint32_t version, const T* items, std::size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "Snapshot sections must be trivially copyable");
+        if (name.empty() || name.size() >= snapshot_detail::kNameSize) {
+            throw std::invalid_argument("snapshot section name \"" + name + "\" must be 1 to 39 bytes");
+        }
+        for (const Section& section : m_sections) {
+            if (name == section.name) {
+                throw std::invalid_argument("duplicate snapshot section \"" + name + "\"");
+            }
+        }
+        const auto* bytes = reinterpret_cast<const unsigned char*>(items);
+        m_sections.push_back(Section{name, version, std::vector<unsigned char>(bytes, bytes + count * sizeof(T))});
+    }
+
+    std::size_t sectionCount() const { return m_sections.size(); }
+
+    // Atomically replaces path with the sections added so far. Throws
+    // std::runtime_error on I/O failure; the previous file is then intact.
+    void commit(const std::string& path) const {
+        std::vector<unsigned char> image = build();
+#ifndef _WIN32
+        std::string temp = path + ".tmp." + std::to_string(::getpid());
+        int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw snapshot_detail::systemError("cannot create snapshot", temp);
+        }
+        std::size_t written = 0;
+        while (written < image.size()) {
+            ssize_t n = ::write(fd, image.data() + written, image.size() - written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                auto error = snapshot_detail::systemError("cannot write snapshot", temp);
+                ::close(fd);
+                ::unlink(temp.c_str());
+                throw error;
+            }
+            written += static_cast<std::size_t>(n);
+        }
+        if (::fsync(fd) != 0 || ::close(fd) != 0) {
+            auto error = snapshot_detail::systemError("cannot flush snapshot", temp);
+            ::unlink(temp.c_str());
+            throw error;
+        }
+        if (::rename(temp.c_str(), path.c_str()) != 0) {
+            auto error = snapshot_detail::systemError("cannot replace snapshot", path);
+            ::unlink(temp.c_str());
+            throw error;
+        }
+        std::size_t slash = path.rfind('/');
+        std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd >= 0) { // Makes the rename itself durable; best effort
+            ::fsync(dirFd);
+            ::close(dirFd);
+        }
+#else
+        static_cast<void>(image);
+        throw std::runtime_error("snapshots are unsupported on this platform: " + path);
+#endif
+    }
+
+private:
+    struct Section {
+        std::string name;
+        std::uint32_t version;
+        std::vector<unsigned char> bytes;
+    };
+
+    std::vector<unsigned char> build() const {
+        using namespace snapshot_detail;
+        std::size_t offset = alignUp(sizeof(FileHeader) + m_sections.size() * sizeof(SectionEntry));
+        std::vector<SectionEntry> entries(m_sections.size());
+        for (std::size_t i = 0; i < m_sections.size(); ++i) {
+            std::memset(&entries[i], 0, sizeof(SectionEntry));
+            std::memcpy(entries[i].name, m_sections[i].name.data(), m_sections[i].name.size());
+            entries[i].version = m_sections[i].version;
+            entries[i].offset = offset;
+            entries[i].size = m_sections[i].bytes.size();
+            offset = alignUp(offset + m_sections[i].bytes.size());
+        }
+
+        std::vector<unsigned char> image(offset, 0);
+        std::memcpy(image.data() + sizeof(FileHeader), entries.data(), entries.size() * sizeof(SectionEntry));
+        for (std::size_t i = 0; i < m_sections.size(); ++i) {
+            if (!m_sections[i].bytes.empty()) {
+                std::memcpy(image.data() + entries[i].offset, m_sections[i].bytes.data(), m_sections[i].bytes.size());
+            }
+        }
+
+        FileHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.formatVersion = kFormatVersion;
+        header.sectionCount = static_cast<std::uint32_t>(m_sections.size());
+        header.fileSize = image.size();
+        header.checksum = fnv1a(image.data() + sizeof(FileHeader), image.size() - sizeof(FileHeader));
+        header.createdWallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        std::memcpy(image.data(), &header, sizeof(header));
+        return image;
+    }
+
+    std::vector<Section> m_sections;
+};
+
+class SnapshotReader {
+public:
+    // Maps and validates path. Throws std::runtime_error if it is missing,
+    // truncated, corrupt or in an unknown format version.
+    explicit SnapshotReader(const std::string& path) : m_path(path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw snapshot_detail::systemError("cannot open snapshot", path);
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            auto error = snapshot_detail::systemError("cannot stat snapshot", path);
+            ::close(fd);
+            throw error;
+        }
+        m_size = static_cast<std::size_t>(info.st_size);
+        if (m_size < sizeof(snapshot_detail::FileHeader)) {
+            ::close(fd);
+            throw std::runtime_error("snapshot " + path + " is truncated");
+        }
+        void* base = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file
+        if (base == MAP_FAILED) {
+            throw snapshot_detail::systemError("cannot map snapshot", path);
+        }
+        m_base = static_cast<const unsigned char*>(base);
+        try {
+            validate();
+        } catch (...) {
+            ::munmap(const_cast<unsigned char*>(m_base), m_size);
+            throw;
+        }
+#else
+        throw std::runtime_error("snapshots are unsupported on this platform: " + path);
+#endif
+    }
+
+    ~SnapshotReader() {
+#ifndef _WIN32
+        ::munmap(const_cast<unsigned char*>(m_base), m_size);
+#endif
+    }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    // The section's single value, or nullptr if it is absent or was saved
+    // with another version or size. Valid while the reader lives.
+    template <typename T>
+    const T* find(const std::string& name, std::uint32_t version) const {
+        SnapshotArray<T> items = findArray<T>(name, version);
+        return items.count == 1 ? items.data : nullptr;
+    }
+
+    // Empty if absent, another version, or not a whole number of T.
+    template <typename T>
+    SnapshotArray<T> findArray(const std::string& name, std::uint32_t version) const {
+        static_assert(std::is_trivially_copyable<T>::value, "Snapshot sections must be trivially copyable");
+        static_assert(alignof(T) <= snapshot_detail::kAlignment, "Snapshot payloads are 64-byte aligned");
+        const snapshot_detail::SectionEntry* entry = entryFor(name);
+        SnapshotArray<T> items;
+        if (entry == nullptr || entry->version != version || entry->size % sizeof(T) != 0) {
+            return items;
+        }
+        items.data = reinterpret_cast<const T*>(m_base + entry->offset);
+        items.count = static_cast<std::size_t>(entry->size / sizeof(T));
+        return items;
+    }
+
+    std::size_t sectionCount() const { return header().sectionCount; }
+    std::size_t size() const { return m_size; }
+    std::int64_t createdWallNs() const { return header().createdWallNs; }
+    const std::string& path() const { return m_path; }
+
+private:
+    const snapshot_detail::FileHeader& header() const {
+        return *reinterpret_cast<const snapshot_detail::FileHeader*>(m_base);
+    }
+
+    const snapshot_detail::SectionEntry* entries() const {
+        return reinterpret_cast<const snapshot_detail::SectionEntry*>(m_base + sizeof(snapshot_detail::FileHeader));
+    }
+
+    const snapshot_detail::SectionEntry* entryFor(const std::string& name) const {
+        if (name.size() >= snapshot_detail::kNameSize) {
+            return nullptr;
+        }
+        for (std::size_t i = 0; i < sectionCount(); ++i) {
+            const snapshot_detail::SectionEntry& entry = entries()[i];
+            if (std::strncmp(entry.name, name.c_str(), snapshot_detail::kNameSize) == 0) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    void validate() const {
+        using namespace snapshot_detail;
+        const FileHeader& h = header();
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+            throw std::runtime_error(m_path + " is not an HVAC snapshot");
+        }
+        if (h.formatVersion != kFormatVersion) {
+            throw std::runtime_error("snapshot " + m_path + " has unsupported format version " +
+                                     std::to_string(h.formatVersion));
+        }
+        if (h.fileSize != m_size ||
+            m_size - sizeof(FileHeader) < static_cast<std::uint64_t>(h.sectionCount) * sizeof(SectionEntry)) {
+            throw std::runtime_error("snapshot " + m_path + " is truncated");
+        }
+        if (fnv1a(m_base + sizeof(FileHeader), m_size - sizeof(FileHeader)) != h.checksum) {
+            throw std::runtime_error("snapshot " + m_path + " is corrupt (checksum mismatch)");
+        }
+        for (std::size_t i = 0; i < h.sectionCount; ++i) {
+            const SectionEntry& entry = entries()[i];
+            if (entry.offset % kAlignment != 0 || entry.offset > m_size || entry.size > m_size - entry.offset ||
+                entry.name[kNameSize - 1] != '\0') {
+                throw std::runtime_error("snapshot " + m_path + " has a malformed section table");
+            }
+        }
+    }
+
+    std::string m_path;
+    const unsigned char* m_base = nullptr;
+    std::size_t m_size = 0;
+};
+
+#endif // HVAC_SNAPSHOT_H
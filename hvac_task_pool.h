@@ -0,0 +1,168 @@
+// hvac_task_pool.h
+#ifndef HVAC_TASK_POOL_H
+#define HVAC_TASK_POOL_H
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for data-parallel passes over the control list.
+// parallelFor() splits a range into chunks and deals them round-robin onto
+// per-worker deques. Owners pop from the back of their own deque; idle
+// workers steal from the front of others', so a few slow controls do not
+// leave the rest of the pool idle. The calling thread helps and returns only
+// once every chunk has finished, giving a fixed join point before render.
+class WorkStealingPool {
+public:
+    using RangeFn = std::function<void(std::size_t begin, std::size_t end)>;
+
+    explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency()) {
+        unsigned count = threads > 1 ? threads - 1 : 0; // The caller is a worker too
+        m_queues.reserve(count + 1);
+        for (unsigned i = 0; i <= count; ++i) {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        for (unsigned i = 0; i < count; ++i) {
+            m_threads.emplace_back([this, i] { workerLoop(i + 1); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_idleMutex);
+            m_stopping = true;
+        }
+        m_idle.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(m_queues.size()); }
+
+    // Runs body over [0, count) in chunks of at most chunk items and blocks
+    // until all of them are done. Not reentrant from inside body.
+    void parallelFor(std::size_t count, std::size_t chunk, const RangeFn& body) {
+        if (count == 0) {
+            return;
+        }
+        chunk = std::max<std::size_t>(chunk, 1);
+        if (m_threads.empty() || count <= chunk) {
+            body(0, count); // Not worth a hand-off
+            return;
+        }
+
+        Batch batch;
+        batch.remaining.store((count + chunk - 1) / chunk, std::memory_order_relaxed);
+        std::size_t target = 0;
+        for (std::size_t begin = 0; begin < count; begin += chunk) {
+            Queue& queue = *m_queues[target];
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.jobs.push_back(Job{begin, std::min(begin + chunk, count), &body, &batch});
+            }
+            target = (target + 1) % m_queues.size();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_idleMutex);
+            ++m_epoch;
+        }
+        m_idle.notify_all();
+
+        // Help out from slot 0, then wait for chunks still running elsewhere.
+        Job job;
+        while (batch.remaining.load(std::memory_order_acquire) > 0 && takeJob(0, job)) {
+            run(job);
+        }
+        std::unique_lock<std::mutex> lock(batch.mutex);
+        batch.done.wait(lock, [&batch] { return batch.remaining.load(std::memory_order_acquire) == 0; });
+    }
+
+private:
+    struct Batch {
+        std::atomic<std::size_t> remaining{0};
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+
+    struct Job {
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        const RangeFn* body = nullptr;
+        Batch* batch = nullptr;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    // Own deque first (LIFO, cache-warm), then steal FIFO from the others.
+    bool takeJob(std::size_t self, Job& job) {
+        {
+            Queue& own = *m_queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                job = own.jobs.back();
+                own.jobs.pop_back();
+                return true;
+            }
+        }
+        for (std::size_t offset = 1; offset < m_queues.size(); ++offset) {
+            Queue& victim = *m_queues[(self + offset) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                job = victim.jobs.front();
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void run(const Job& job) {
+        (*job.body)(job.begin, job.end);
+        // Decrement under the batch mutex: once the waiter sees zero it may
+        // destroy the batch, so nothing may touch it after this unlock.
+        std::lock_guard<std::mutex> lock(job.batch->mutex);
+        if (job.batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            job.batch->done.notify_all();
+        }
+    }
+
+    void workerLoop(std::size_t self) {
+        std::uint64_t seenEpoch = 0;
+        for (;;) {
+            Job job;
+            while (takeJob(self, job)) {
+                run(job);
+            }
+            std::unique_lock<std::mutex> lock(m_idleMutex);
+            m_idle.wait(lock, [&] { return m_stopping || m_epoch != seenEpoch; });
+            if (m_stopping) {
+                return;
+            }
+            seenEpoch = m_epoch;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues; // [0] belongs to the calling thread
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_idleMutex;
+    std::condition_variable m_idle;
+    std::uint64_t m_epoch = 0; // Bumped per batch so sleeping workers rescan
+    bool m_stopping = false;
+};
+
+#endif // HVAC_TASK_POOL_H
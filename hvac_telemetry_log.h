@@ -0,0 +1,381 @@
+// hvac_telemetry_log.h
+#ifndef HVAC_TELEMETRY_LOG_H
+#define HVAC_TELEMETRY_LOG_H
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Append-only binary log of HVAC changes, kept as a directory of numbered
+// segment files ("telemetry-00000001.seg", ...).
+//
+// Each segment is a 64-byte header followed by fixed 16-byte records. The
+// writer maps the whole segment once. An append takes the writer's mutex,
+// copies the record into mapped memory and release-stores the header's
+// record count; only moving on to the next file, when a segment fills up,
+// makes syscalls. When it closes a segment, it trims the file to the
+// records written. Failures after construction never reach the appender:
+// they go to the error handler, and a segment that cannot be created stops
+// the log.
+// Timestamps are nanoseconds and never decrease within a writer's segments,
+// so readers binary-search each segment instead of decoding all of them.
+// The log is POSIX-only; on _WIN32 opening one throws.
+
+enum class TelemetryKind : std::uint16_t { Temperature = 1, FanLevel = 2, Mode = 3 };
+
+struct TelemetryRecord {
+    std::int64_t timestampNs;
+    std::int32_t value;
+    TelemetryKind kind;
+    std::uint16_t reserved;
+};
+static_assert(sizeof(TelemetryRecord) == 16, "Telemetry records are 16 bytes on disk");
+
+namespace telemetry_detail {
+
+constexpr char kMagic[8] = {'H', 'V', 'A', 'C', 'T', 'L', 'M', '1'};
+constexpr std::uint32_t kVersion = 1;
+
+struct SegmentHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint64_t capacity;
+    std::atomic<std::uint64_t> count; // Published with release after each record
+    std::uint64_t sequence;
+    std::uint8_t reserved[24];
+};
+static_assert(sizeof(SegmentHeader) == 64, "Segment header is 64 bytes on disk");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "The mapped record count must be a plain lock-free word");
+
+inline std::runtime_error systemError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+inline std::string segmentPath(const std::string& directory, std::uint64_t sequence) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "telemetry-%08llu.seg", static_cast<unsigned long long>(sequence));
+    return directory + "/" + name;
+}
+
+// Sequence numbers of the segments in directory, ascending.
+inline std::vector<std::uint64_t> listSegments(const std::string& directory) {
+    std::vector<std::uint64_t> sequences;
+#ifndef _WIN32
+    DIR* dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+        return sequences;
+    }
+    while (dirent* entry = ::readdir(dir)) {
+        unsigned long long sequence = 0;
+        char tail = 0;
+        if (std::sscanf(entry->d_name, "telemetry-%8llu.se%c", &sequence, &tail) == 2 && tail == 'g') {
+            sequences.push_back(sequence);
+        }
+    }
+    ::closedir(dir);
+    std::sort(sequences.begin(), sequences.end());
+#else
+    static_cast<void>(directory);
+#endif
+    return sequences;
+}
+
+} // namespace telemetry_detail
+
+class TelemetryLogWriter {
+public:
+    static constexpr std::uint64_t kDefaultSegmentRecords = 1u << 20; // 16 MiB segments
+    using ErrorHandler = std::function<void(const std::string&)>;
+
+    // Creates directory if needed and starts a new segment after any that
+    // already exist, so earlier runs stay readable. Throws std::runtime_error.
+    explicit TelemetryLogWriter(std::string directory, std::uint64_t recordsPerSegment = kDefaultSegmentRecords)
+        : m_directory(std::move(directory)), m_recordsPerSegment(std::max<std::uint64_t>(recordsPerSegment, 1)) {
+#ifndef _WIN32
+        if (::mkdir(m_directory.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw telemetry_detail::systemError("cannot create", m_directory);
+        }
+        std::vector<std::uint64_t> existing = telemetry_detail::listSegments(m_directory);
+        m_sequence = existing.empty() ? 0 : existing.back();
+        openNextSegment();
+#else
+        throw std::runtime_error("telemetry log requires a POSIX system");
+#endif
+    }
+
+    ~TelemetryLogWriter() { closeSegment(); }
+
+    TelemetryLogWriter(const TelemetryLogWriter&) = delete;
+    TelemetryLogWriter& operator=(const TelemetryLogWriter&) = delete;
+
+    // Receives a message for each failure after construction: a segment
+    // that cannot be trimmed (it stays readable at full size), or one that
+    // cannot be created, after which appends are dropped. Runs under the
+    // writer's mutex. Without a handler, messages go to stderr.
+    void setErrorHandler(ErrorHandler handler) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_onError = std::move(handler);
+    }
+
+    // Safe to call from several setters at once, and does not throw. A
+    // timestamp older than the previous record is raised to it, keeping the
+    // log sorted.
+    void append(TelemetryKind kind, std::int32_t value, std::int64_t timestampNs) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_disabled) {
+            return;
+        }
+        if (m_count == m_recordsPerSegment) {
+            closeSegment();
+            try {
+                openNextSegment(); // The only syscalls on the append path, once per segment
+            } catch (const std::runtime_error& e) {
+                m_disabled = true; // Reported once; later appends are dropped
+                reportError(std::string(e.what()) + "; telemetry logging stopped");
+                return;
+            }
+        }
+        m_lastTimestamp = std::max(m_lastTimestamp, timestampNs);
+        TelemetryRecord& record = m_records[m_count];
+        record.timestampNs = m_lastTimestamp;
+        record.value = value;
+        record.kind = kind;
+        record.reserved = 0;
+        m_header->count.store(++m_count, std::memory_order_release);
+        ++m_appended;
+    }
+
+    // Asks the kernel to write the current segment back; appends don't.
+    void flush() {
+#ifndef _WIN32
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_mapping != nullptr) {
+            ::msync(m_mapping, m_mappingSize, MS_SYNC);
+        }
+#endif
+    }
+
+    std::uint64_t appended() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_appended;
+    }
+
+    // False once a segment could not be created.
+    bool enabled() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_disabled;
+    }
+
+    const std::string& directory() const { return m_directory; }
+
+private:
+    void reportError(const std::string& message) {
+        if (m_onError) {
+            m_onError(message);
+        } else {
+            std::fprintf(stderr, "%s\n", message.c_str());
+        }
+    }
+
+    void openNextSegment() {
+#ifndef _WIN32
+        ++m_sequence;
+        std::string path = telemetry_detail::segmentPath(m_directory, m_sequence);
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) {
+            throw telemetry_detail::systemError("cannot create", path);
+        }
+        m_mappingSize = sizeof(telemetry_detail::SegmentHeader) + m_recordsPerSegment * sizeof(TelemetryRecord);
+        if (::ftruncate(fd, static_cast<off_t>(m_mappingSize)) != 0) {
+            ::close(fd);
+            throw telemetry_detail::systemError("cannot size", path);
+        }
+        void* mapping = ::mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw telemetry_detail::systemError("cannot map", path);
+        }
+        m_fd = fd;
+        m_mapping = mapping;
+        m_header = new (mapping) telemetry_detail::SegmentHeader{};
+        std::memcpy(m_header->magic, telemetry_detail::kMagic, sizeof(telemetry_detail::kMagic));
+        m_header->version = telemetry_detail::kVersion;
+        m_header->recordSize = sizeof(TelemetryRecord);
+        m_header->capacity = m_recordsPerSegment;
+        m_header->sequence = m_sequence;
+        m_records = reinterpret_cast<TelemetryRecord*>(static_cast<char*>(mapping) + sizeof(telemetry_detail::SegmentHeader));
+        m_count = 0;
+#endif
+    }
+
+    // Unmaps the segment and trims the file to the records actually written.
+    void closeSegment() {
+#ifndef _WIN32
+        if (m_mapping == nullptr) {
+            return;
+        }
+        ::munmap(m_mapping, m_mappingSize);
+        off_t used = static_cast<off_t>(sizeof(telemetry_detail::SegmentHeader) + m_count * sizeof(TelemetryRecord));
+        if (::ftruncate(m_fd, used) != 0) {
+            // The full-size file stays readable, since readers trust the header's count.
+            std::string path = telemetry_detail::segmentPath(m_directory, m_sequence);
+            reportError(telemetry_detail::systemError("cannot trim", path).what());
+        }
+        ::close(m_fd);
+        m_mapping = nullptr;
+        m_header = nullptr;
+        m_records = nullptr;
+        m_fd = -1;
+#endif
+    }
+
+    std::string m_directory;
+    std::uint64_t m_recordsPerSegment;
+    mutable std::mutex m_mutex; // Serializes appenders and rollover
+    std::uint64_t m_sequence = 0;
+    int m_fd = -1;
+    void* m_mapping = nullptr;
+    std::size_t m_mappingSize = 0;
+    telemetry_detail::SegmentHeader* m_header = nullptr;
+    TelemetryRecord* m_records = nullptr;
+    std::uint64_t m_count = 0; // Records in the current segment
+    std::uint64_t m_appended = 0;
+    bool m_disabled = false;
+    ErrorHandler m_onError;
+    std::int64_t m_lastTimestamp = std::numeric_limits<std::int64_t>::min();
+};
+
+// Read-only view of every segment in a log directory, each mapped once.
+// A live writer's current segment can be read too; records appended after
+// the reader opened the log are not visible.
+class TelemetryLogReader {
+public:
+    // Skips files with a foreign header or a truncated body. Throws
+    // std::runtime_error if the directory has no readable segment.
+    explicit TelemetryLogReader(const std::string& directory) {
+#ifndef _WIN32
+        for (std::uint64_t sequence : telemetry_detail::listSegments(directory)) {
+            mapSegment(telemetry_detail::segmentPath(directory, sequence));
+        }
+#endif
+        if (m_segments.empty()) {
+            throw std::runtime_error("no telemetry segments in " + directory);
+        }
+    }
+
+    ~TelemetryLogReader() {
+#ifndef _WIN32
+        for (const Segment& segment : m_segments) {
+            ::munmap(segment.mapping, segment.mappingSize);
+        }
+#endif
+    }
+
+    TelemetryLogReader(const TelemetryLogReader&) = delete;
+    TelemetryLogReader& operator=(const TelemetryLogReader&) = delete;
+
+    std::size_t segmentCount() const { return m_segments.size(); }
+
+    std::uint64_t recordCount() const {
+        std::uint64_t total = 0;
+        for (const Segment& segment : m_segments) {
+            total += segment.count;
+        }
+        return total;
+    }
+
+    std::int64_t firstTimestamp() const { return m_segments.front().records[0].timestampNs; }
+    std::int64_t lastTimestamp() const {
+        const Segment& last = m_segments.back();
+        return last.records[last.count - 1].timestampNs;
+    }
+
+    // Calls visit(const TelemetryRecord&) for every record with a timestamp
+    // in [fromNs, toNs), in log order. Segments outside the range are skipped
+    // and the start is found by binary search. Returns the records visited.
+    template <typename Visitor>
+    std::uint64_t scan(std::int64_t fromNs, std::int64_t toNs, Visitor&& visit) const {
+        std::uint64_t visited = 0;
+        for (const Segment& segment : m_segments) {
+            const TelemetryRecord* begin = segment.records;
+            const TelemetryRecord* end = segment.records + segment.count;
+            if (end[-1].timestampNs < fromNs) {
+                continue;
+            }
+            if (begin->timestampNs >= toNs) {
+                continue; // Not break: separate runs may use different clocks
+            }
+            const TelemetryRecord* it = std::lower_bound(
+                begin, end, fromNs,
+                [](const TelemetryRecord& record, std::int64_t t) { return record.timestampNs < t; });
+            for (; it != end && it->timestampNs < toNs; ++it) {
+                visit(*it);
+                ++visited;
+            }
+        }
+        return visited;
+    }
+
+private:
+    struct Segment {
+        void* mapping;
+        std::size_t mappingSize;
+        const TelemetryRecord* records;
+        std::uint64_t count;
+    };
+
+#ifndef _WIN32
+    void mapSegment(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(telemetry_detail::SegmentHeader)) {
+            ::close(fd);
+            return;
+        }
+        std::size_t size = static_cast<std::size_t>(info.st_size);
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // The mapping keeps the file alive
+        if (mapping == MAP_FAILED) {
+            return;
+        }
+        const auto* header = static_cast<const telemetry_detail::SegmentHeader*>(mapping);
+        std::uint64_t stored = (size - sizeof(telemetry_detail::SegmentHeader)) / sizeof(TelemetryRecord);
+        std::uint64_t count = std::min(header->count.load(std::memory_order_acquire), stored);
+        if (std::memcmp(header->magic, telemetry_detail::kMagic, sizeof(telemetry_detail::kMagic)) != 0 ||
+            header->version != telemetry_detail::kVersion || header->recordSize != sizeof(TelemetryRecord) ||
+            count == 0) {
+            ::munmap(mapping, size);
+            return;
+        }
+        const auto* records = reinterpret_cast<const TelemetryRecord*>(
+            static_cast<const char*>(mapping) + sizeof(telemetry_detail::SegmentHeader));
+        m_segments.push_back(Segment{mapping, size, records, count});
+    }
+#endif
+
+    std::vector<Segment> m_segments;
+};
+
+#endif // HVAC_TELEMETRY_LOG_H
@@ -0,0 +1,157 @@
+// hvac_thermal_model.h
+#ifndef HVAC_THERMAL_MODEL_H
+#define HVAC_THERMAL_MODEL_H
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Batched closed-loop thermal model for many cabin/zone simulations.
+//
+// Each zone has a first-order plant (heater/cooler output pushes the cabin
+// temperature, losses pull it toward ambient) and its own PID controller
+// with configurable gains, output limits and conditional-integration
+// anti-windup. State is stored as one float array per field so step() can
+// run eight zones per instruction with AVX2 (build with -mavx2 or
+// -march=native); other builds use the scalar loop, which computes the same
+// formula.
+
+struct PidGains {
+    float kp = 0.8f;
+    float ki = 0.05f;
+    float kd = 0.1f;
+};
+
+struct ThermalParams {
+    float heatGain = 0.02f;    // °C per second per unit of controller output
+    float lossCoeff = 0.002f;  // Fraction of (temp - ambient) lost per second
+    float outputMin = -10.0f;  // Full cooling
+    float outputMax = 10.0f;   // Full heating
+};
+
+class ZoneThermalBatch {
+public:
+    explicit ZoneThermalBatch(ThermalParams params = ThermalParams{}) : m_params(params) {}
+
+    std::size_t addZone(float temperature, float setpoint, float ambient, PidGains gains = PidGains{}) {
+        m_temperature.push_back(temperature);
+        m_setpoint.push_back(setpoint);
+        m_ambient.push_back(ambient);
+        m_integral.push_back(0.0f);
+        m_prevError.push_back(setpoint - temperature);
+        m_output.push_back(0.0f);
+        m_kp.push_back(gains.kp);
+        m_ki.push_back(gains.ki);
+        m_kd.push_back(gains.kd);
+        return m_temperature.size() - 1;
+    }
+
+    std::size_t size() const { return m_temperature.size(); }
+
+    void setSetpoint(std::size_t zone, float setpoint) { m_setpoint[zone] = setpoint; }
+    void setAmbient(std::size_t zone, float ambient) { m_ambient[zone] = ambient; }
+    void setGains(std::size_t zone, PidGains gains) {
+        m_kp[zone] = gains.kp;
+        m_ki[zone] = gains.ki;
+        m_kd[zone] = gains.kd;
+    }
+
+    float temperature(std::size_t zone) const { return m_temperature[zone]; }
+    float output(std::size_t zone) const { return m_output[zone]; }
+    const float* temperatures() const { return m_temperature.data(); }
+
+    // Advances every zone by dt seconds: PID update, then plant update.
+    void step(float dt) {
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        i = stepAvx2(dt);
+#endif
+        stepScalar(dt, i);
+    }
+
+    static constexpr bool vectorized() {
+#if defined(__AVX2__)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    // Also handles the tail that does not fill a full vector.
+    void stepScalar(float dt, std::size_t begin) {
+        const float invDt = 1.0f / dt;
+        const std::size_t n = m_temperature.size();
+        for (std::size_t i = begin; i < n; ++i) {
+            float error = m_setpoint[i] - m_temperature[i];
+            float derivative = (error - m_prevError[i]) * invDt;
+            float integral = m_integral[i] + error * dt;
+            float raw = m_kp[i] * error + m_ki[i] * integral + m_kd[i] * derivative;
+            float out = std::min(std::max(raw, m_params.outputMin), m_params.outputMax);
+            // Anti-windup: hold the integrator while saturated in the direction
+            // the error is still pushing.
+            bool windup = raw != out && error * (raw - out) > 0.0f;
+            m_integral[i] = windup ? m_integral[i] : integral;
+            m_prevError[i] = error;
+            m_output[i] = out;
+            m_temperature[i] += dt * (m_params.heatGain * out -
+                                      m_params.lossCoeff * (m_temperature[i] - m_ambient[i]));
+        }
+    }
+
+#if defined(__AVX2__)
+    std::size_t stepAvx2(float dt) {
+        const std::size_t n = m_temperature.size();
+        const __m256 vDt = _mm256_set1_ps(dt);
+        const __m256 vInvDt = _mm256_set1_ps(1.0f / dt);
+        const __m256 vMin = _mm256_set1_ps(m_params.outputMin);
+        const __m256 vMax = _mm256_set1_ps(m_params.outputMax);
+        const __m256 vGain = _mm256_set1_ps(m_params.heatGain);
+        const __m256 vLoss = _mm256_set1_ps(m_params.lossCoeff);
+        const __m256 vZero = _mm256_setzero_ps();
+
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 temp = _mm256_loadu_ps(&m_temperature[i]);
+            __m256 prevError = _mm256_loadu_ps(&m_prevError[i]);
+            __m256 integralOld = _mm256_loadu_ps(&m_integral[i]);
+
+            __m256 error = _mm256_sub_ps(_mm256_loadu_ps(&m_setpoint[i]), temp);
+            __m256 derivative = _mm256_mul_ps(_mm256_sub_ps(error, prevError), vInvDt);
+            __m256 integral = _mm256_add_ps(integralOld, _mm256_mul_ps(error, vDt));
+
+            __m256 raw = _mm256_mul_ps(_mm256_loadu_ps(&m_kp[i]), error);
+            raw = _mm256_add_ps(raw, _mm256_mul_ps(_mm256_loadu_ps(&m_ki[i]), integral));
+            raw = _mm256_add_ps(raw, _mm256_mul_ps(_mm256_loadu_ps(&m_kd[i]), derivative));
+            __m256 out = _mm256_min_ps(_mm256_max_ps(raw, vMin), vMax);
+
+            __m256 excess = _mm256_sub_ps(raw, out);
+            __m256 windup = _mm256_and_ps(_mm256_cmp_ps(excess, vZero, _CMP_NEQ_OQ),
+                                          _mm256_cmp_ps(_mm256_mul_ps(error, excess), vZero, _CMP_GT_OQ));
+            _mm256_storeu_ps(&m_integral[i], _mm256_blendv_ps(integral, integralOld, windup));
+            _mm256_storeu_ps(&m_prevError[i], error);
+            _mm256_storeu_ps(&m_output[i], out);
+
+            __m256 loss = _mm256_mul_ps(vLoss, _mm256_sub_ps(temp, _mm256_loadu_ps(&m_ambient[i])));
+            __m256 delta = _mm256_sub_ps(_mm256_mul_ps(vGain, out), loss);
+            _mm256_storeu_ps(&m_temperature[i], _mm256_add_ps(temp, _mm256_mul_ps(vDt, delta)));
+        }
+        return i;
+    }
+#endif
+
+    ThermalParams m_params;
+    std::vector<float> m_temperature;
+    std::vector<float> m_setpoint;
+    std::vector<float> m_ambient;
+    std::vector<float> m_integral;
+    std::vector<float> m_prevError;
+    std::vector<float> m_output;
+    std::vector<float> m_kp;
+    std::vector<float> m_ki;
+    std::vector<float> m_kd;
+};
+
+#endif // HVAC_THERMAL_MODEL_H
@@ -0,0 +1,259 @@
+// hvac_thread_placement.h
+#ifndef HVAC_THREAD_PLACEMENT_H
+#define HVAC_THREAD_PLACEMENT_H
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hvac_periodic.h"
+#if defined(__linux__)
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+// Where HVAC threads run: CPU pinning, optional SCHED_FIFO priority, and
+// optional mlockall, configured per thread role.
+//
+// A spec is a comma-separated list of role=cpu[:fifoN] entries plus an
+// optional "mlock" flag, for example
+//     control=1:fifo80,render=0,log=0,mlock
+// Roles are control (periodic control loops), render (screen redraws) and
+// log (console, logging and other housekeeping). cpu "*" leaves a role
+// unpinned, so "control=*:fifo80" only raises its priority. Each thread calls
+// applyThreadPlacement(role) as it starts; roles missing from the spec keep
+// the OS defaults. The spec comes from --placement in check.cpp or from the
+// HVAC_PLACEMENT environment variable.
+//
+// Pinning control loops away from the render thread, and giving them a FIFO
+// priority above it, stops a long redraw from delaying a control tick.
+// SCHED_FIFO and mlockall usually need CAP_SYS_NICE / CAP_IPC_LOCK or
+// matching rlimits. A failed step is reported and skipped, so the program
+// still runs, just without that guarantee. Linux-only; elsewhere every step
+// reports "unsupported".
+
+enum class ThreadRole { Control, Render, Logging };
+
+struct ThreadPlacement {
+    int cpu = -1; // -1: not pinned
+    int fifoPriority = 0; // 0: normal scheduling; 1..99: SCHED_FIFO
+    bool configured = false;
+};
+
+class PlacementConfig {
+public:
+    // Throws std::invalid_argument on a malformed spec.
+    static PlacementConfig parse(const std::string& spec) {
+        PlacementConfig config;
+        std::size_t start = 0;
+        while (start <= spec.size()) {
+            std::size_t end = spec.find(',', start);
+            if (end == std::string::npos) {
+                end = spec.size();
+            }
+            std::string entry = spec.substr(start, end - start);
+            start = end + 1;
+            if (entry.empty()) {
+                continue;
+            }
+            if (entry == "mlock") {
+                config.m_lockMemory = true;
+                continue;
+            }
+            std::size_t equals = entry.find('=');
+            if (equals == std::string::npos) {
+                throw std::invalid_argument("placement entry \"" + entry + "\" is not role=cpu[:fifoN]");
+            }
+            ThreadPlacement& placement = config.m_roles[roleIndex(parseRole(entry.substr(0, equals)))];
+            std::string value = entry.substr(equals + 1);
+            std::size_t colon = value.find(':');
+            std::string cpu = value.substr(0, colon);
+            placement.cpu = cpu == "*" ? -1 : parseNumber(cpu, 0, 1023, entry);
+            if (colon != std::string::npos) {
+                std::string policy = value.substr(colon + 1);
+                if (policy.compare(0, 4, "fifo") != 0) {
+                    throw std::invalid_argument("placement entry \"" + entry + "\" has an unknown policy");
+                }
+                placement.fifoPriority = parseNumber(policy.substr(4), 1, 99, entry);
+            }
+            placement.configured = true;
+        }
+        return config;
+    }
+
+    // HVAC_PLACEMENT, or an empty config (OS defaults) if unset.
+    static PlacementConfig fromEnvironment() {
+        const char* spec = std::getenv("HVAC_PLACEMENT");
+        return spec != nullptr ? parse(spec) : PlacementConfig{};
+    }
+
+    const ThreadPlacement& placement(ThreadRole role) const { return m_roles[roleIndex(role)]; }
+    ThreadPlacement& placement(ThreadRole role) { return m_roles[roleIndex(role)]; }
+    bool lockMemory() const { return m_lockMemory; }
+    bool empty() const {
+        return !m_lockMemory && !m_roles[0].configured && !m_roles[1].configured && !m_roles[2].configured;
+    }
+
+    // Process-wide config read by applyThreadPlacement(). Set it once at
+    // startup, before the threads it places are started.
+    static PlacementConfig& current() {
+        static PlacementConfig config;
+        return config;
+    }
+
+    static const char* roleName(ThreadRole role) {
+        switch (role) {
+            case ThreadRole::Control: return "control";
+            case ThreadRole::Render: return "render";
+            case ThreadRole::Logging: return "log";
+        }
+        return "?";
+    }
+
+private:
+    static std::size_t roleIndex(ThreadRole role) { return static_cast<std::size_t>(role); }
+
+    static ThreadRole parseRole(const std::string& name) {
+        if (name == "control") return ThreadRole::Control;
+        if (name == "render") return ThreadRole::Render;
+        if (name == "log") return ThreadRole::Logging;
+        throw std::invalid_argument("unknown thread role \"" + name + "\" (control, render, log)");
+    }
+
+    static int parseNumber(const std::string& text, int lo, int hi, const std::string& entry) {
+        char* end = nullptr;
+        long value = std::strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0' || value < lo || value > hi) {
+            throw std::invalid_argument("placement entry \"" + entry + "\" is out of range");
+        }
+        return static_cast<int>(value);
+    }
+
+    std::array<ThreadPlacement, 3> m_roles{};
+    bool m_lockMemory = false;
+};
+
+// Applies placement to the calling thread. Returns false, with one line per
+// failed step written to warnings, if any step could not be applied.
+inline bool applyPlacement(const ThreadPlacement& placement, const char* who, std::ostream& warnings) {
+    if (!placement.configured) {
+        return true;
+    }
+    bool ok = true;
+#if defined(__linux__)
+    if (placement.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(static_cast<std::size_t>(placement.cpu), &cpus);
+        if (int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+            warnings << "[placement] " << who << ": cannot pin to CPU " << placement.cpu << ": "
+                     << std::strerror(error) << "\n";
+            ok = false;
+        }
+    }
+    if (placement.fifoPriority > 0) {
+        sched_param param{};
+        param.sched_priority = placement.fifoPriority;
+        if (int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) {
+            warnings << "[placement] " << who << ": cannot set SCHED_FIFO " << placement.fifoPriority << ": "
+                     << std::strerror(error) << "\n";
+            ok = false;
+        }
+    }
+#else
+    warnings << "[placement] " << who << ": thread placement is unsupported on this platform\n";
+    ok = false;
+#endif
+    return ok;
+}
+
+inline bool applyThreadPlacement(ThreadRole role, std::ostream& warnings) {
+    return applyPlacement(PlacementConfig::current().placement(role), PlacementConfig::roleName(role), warnings);
+}
+
+// mlockall(MCL_CURRENT | MCL_FUTURE) if the current config asks for it, so
+// control loops never stall on a page fault. Call once, early in main.
+inline bool applyMemoryLock(std::ostream& warnings) {
+    if (!PlacementConfig::current().lockMemory()) {
+        return true;
+    }
+#if defined(__linux__)
+    if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        warnings << "[placement] cannot lock memory: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+#else
+    warnings << "[placement] memory locking is unsupported on this platform\n";
+    return false;
+#endif
+}
+
+// Latency probe: a 1 ms control-style loop runs on the probe thread while
+// one busy "redraw" thread per CPU competes with it, so wake-up latency
+// reflects real co-scheduling. Run once with default scheduling and once
+// with the config's control/render placement and compare the two
+// LoopStats. The load threads burn CPU in bursts of loadBurst and then yield
+// for a moment, as a redraw would.
+struct LatencyProbeResult {
+    const LoopStats* stats = nullptr;
+    std::uint64_t loadBursts = 0;
+};
+
+inline LatencyProbeResult runLatencyProbe(const char* name, const PlacementConfig& config, bool placed,
+                                          std::chrono::milliseconds duration, std::ostream& warnings,
+                                          std::chrono::microseconds loadBurst = std::chrono::microseconds(5000)) {
+    std::atomic<bool> running{true};
+    std::atomic<std::uint64_t> bursts{0};
+    std::vector<std::thread> load;
+    unsigned cpus = std::thread::hardware_concurrency() == 0 ? 1 : std::thread::hardware_concurrency();
+    std::vector<std::ostringstream> loadWarnings(cpus); // One per thread; warnings is not thread-safe
+    for (unsigned i = 0; i < cpus; ++i) {
+        load.emplace_back([&, i] {
+            if (placed) {
+                applyPlacement(config.placement(ThreadRole::Render), "probe load", loadWarnings[i]);
+            }
+            volatile std::uint64_t sink = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                auto until = std::chrono::steady_clock::now() + loadBurst;
+                while (std::chrono::steady_clock::now() < until) {
+                    sink = sink + 1;
+                }
+                bursts.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+    }
+
+    LatencyProbeResult result;
+    std::ostringstream probeWarnings;
+    std::thread probe([&] {
+        if (placed) {
+            applyPlacement(config.placement(ThreadRole::Control), "probe", probeWarnings);
+        }
+        PeriodicTimer timer(name, std::chrono::milliseconds(1));
+        result.stats = &timer.stats(); // Stays registered (and alive) after the timer goes
+        auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end && timer.wait()) {
+        }
+    });
+    probe.join();
+    running = false;
+    for (auto& thread : load) {
+        thread.join();
+    }
+    result.loadBursts = bursts.load();
+    warnings << probeWarnings.str() << loadWarnings[0].str(); // Load threads all fail alike
+    return result;
+}
+
+#endif // HVAC_THREAD_PLACEMENT_H
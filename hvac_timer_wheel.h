@@ -0,0 +1,361 @@
+// hvac_timer_wheel.h
+#ifndef HVAC_TIMER_WHEEL_H
+#define HVAC_TIMER_WHEEL_H
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Hierarchical timer wheel that runs periodic control tasks on a small,
+// fixed set of threads instead of one sleeping std::thread per updater.
+//
+// Time is quantized into ticks. Four levels of 64 slots each cover 2^24
+// ticks; timers further out are parked in the last level and re-cascaded.
+// Each slot is an intrusive doubly-linked list of timer nodes, so schedule()
+// and cancel() are O(1). A single driver thread advances the wheel; with
+// more than one worker, expired tasks are handed to a worker queue.
+// A periodic task is stored once and run in place, so state a mutable task
+// keeps carries over between runs. It never overlaps itself: an expiry that
+// lands while the previous run is still going is skipped.
+class TimerWheelScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+    using TimerId = std::uint64_t; // (generation << 32) | node index; 0 is never valid
+
+    explicit TimerWheelScheduler(std::chrono::milliseconds tick = std::chrono::milliseconds(10),
+                                 unsigned workers = 1)
+        : m_tick(tick), m_workerCount(workers == 0 ? 1 : workers) {
+        m_heads.fill(kNil);
+    }
+
+    ~TimerWheelScheduler() { stop(); }
+
+    TimerWheelScheduler(const TimerWheelScheduler&) = delete;
+    TimerWheelScheduler& operator=(const TimerWheelScheduler&) = delete;
+
+    // Runs task every period, first after one period. Periods are measured
+    // from the scheduled expiry, not from when the task finished.
+    TimerId schedulePeriodic(std::chrono::milliseconds period, Task task) {
+        return add(period, period, std::move(task));
+    }
+
+    TimerId scheduleOnce(std::chrono::milliseconds delay, Task task) {
+        return add(delay, std::chrono::milliseconds(0), std::move(task));
+    }
+
+    // O(1). Returns false if the id is stale (already fired or cancelled).
+    // A task already handed to a worker may still run once.
+    bool cancel(TimerId id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::uint32_t index = static_cast<std::uint32_t>(id & 0xffffffffu);
+        std::uint32_t generation = static_cast<std::uint32_t>(id >> 32);
+        if (index >= m_nodes.size() || m_nodes[index].generation != generation || !m_nodes[index].active) {
+            return false;
+        }
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    // Runs first on each scheduler thread, e.g. to pin it or raise its
+    // priority. Call before start().
+    void setThreadInit(std::function<void()> init) {
+        m_threadInit = std::move(init);
+    }
+
+    void start() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running) {
+            return;
+        }
+        m_running = true;
+        m_origin = Clock::now();
+        m_now = 0;
+        m_driver = std::thread([this] {
+            runThreadInit();
+            driverLoop();
+        });
+        if (m_workerCount > 1) {
+            for (unsigned i = 0; i < m_workerCount; ++i) {
+                m_workers.emplace_back([this] {
+                    runThreadInit();
+                    workerLoop();
+                });
+            }
+        }
+    }
+
+    // Prompt shutdown: wakes the driver and workers immediately instead of
+    // waiting out the longest period. Tasks already running are finished.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running) {
+                return;
+            }
+            m_running = false;
+        }
+        m_wake.notify_all();
+        m_workReady.notify_all();
+        if (m_driver.joinable()) {
+            m_driver.join();
+        }
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+        m_workers.clear();
+    }
+
+    std::size_t activeTimers() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_active;
+    }
+
+private:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr std::uint32_t kSlots = 1u << kSlotBits;
+    static constexpr std::uint32_t kSlotMask = kSlots - 1;
+    static constexpr std::uint32_t kNil = 0xffffffffu;
+
+    // Shared between a node and the due/worker queues, so a periodic task
+    // runs in place and a cancel() during its run does not destroy it.
+    struct Entry {
+        explicit Entry(Task t) : task(std::move(t)) {}
+
+        Task task;
+        std::atomic<bool> running{false};
+    };
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    struct Node {
+        std::uint64_t expires = 0; // Absolute tick
+        std::uint64_t period = 0;  // Ticks; 0 = one-shot
+        EntryPtr entry;
+        std::uint32_t prev = kNil;
+        std::uint32_t next = kNil;
+        std::uint32_t slot = kNil;  // Index into m_heads while linked
+        std::uint32_t generation = 1;
+        bool active = false;
+    };
+
+    std::uint64_t toTicks(std::chrono::milliseconds duration) const {
+        auto ticks = (duration.count() + m_tick.count() - 1) / m_tick.count();
+        return ticks > 0 ? static_cast<std::uint64_t>(ticks) : 1;
+    }
+
+    TimerId add(std::chrono::milliseconds delay, std::chrono::milliseconds period, Task task) {
+        TimerId id;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::uint32_t index;
+            if (!m_free.empty()) {
+                index = m_free.back();
+                m_free.pop_back();
+            } else {
+                index = static_cast<std::uint32_t>(m_nodes.size());
+                m_nodes.emplace_back();
+            }
+            Node& node = m_nodes[index];
+            node.expires = m_now + toTicks(delay);
+            node.period = period.count() > 0 ? toTicks(period) : 0;
+            node.entry = std::make_shared<Entry>(std::move(task));
+            node.active = true;
+            ++m_active;
+            link(index);
+            id = (static_cast<TimerId>(node.generation) << 32) | index;
+        }
+        m_wake.notify_one(); // The driver may be idle-waiting with no timers
+        return id;
+    }
+
+    void release(std::uint32_t index) {
+        Node& node = m_nodes[index];
+        node.active = false;
+        node.entry.reset();
+        ++node.generation;
+        --m_active;
+        m_free.push_back(index);
+    }
+
+    // Chooses the level whose span covers the remaining delay. expires is
+    // at least m_now + 1 for new and re-armed timers. During a cascade it
+    // may equal m_now, which lands in the level-0 slot advance() is about
+    // to process, so the timer still fires on its own tick.
+    void link(std::uint32_t index) {
+        Node& node = m_nodes[index];
+        std::uint64_t delta = node.expires - m_now;
+        std::uint32_t slot;
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (std::uint64_t(1) << (kSlotBits * (level + 1)))) {
+            ++level;
+        }
+        std::uint64_t when = node.expires;
+        if (level == kLevels - 1 && delta >= (std::uint64_t(1) << (kSlotBits * kLevels))) {
+            when = m_now + (std::uint64_t(1) << (kSlotBits * kLevels)) - 1; // Park and re-cascade later
+        }
+        slot = static_cast<std::uint32_t>(level) * kSlots +
+               static_cast<std::uint32_t>((when >> (kSlotBits * level)) & kSlotMask);
+
+        node.slot = slot;
+        node.prev = kNil;
+        node.next = m_heads[slot];
+        if (node.next != kNil) {
+            m_nodes[node.next].prev = index;
+        }
+        m_heads[slot] = index;
+    }
+
+    void unlink(std::uint32_t index) {
+        Node& node = m_nodes[index];
+        if (node.prev != kNil) {
+            m_nodes[node.prev].next = node.next;
+        } else {
+            m_heads[node.slot] = node.next;
+        }
+        if (node.next != kNil) {
+            m_nodes[node.next].prev = node.prev;
+        }
+        node.prev = node.next = node.slot = kNil;
+    }
+
+    std::uint32_t detachSlot(std::uint32_t slot) {
+        std::uint32_t head = m_heads[slot];
+        m_heads[slot] = kNil;
+        return head;
+    }
+
+    // Advances one tick and collects the tasks that expire on it.
+    void advance(std::vector<EntryPtr>& due) {
+        ++m_now;
+        // Cascade higher levels whose slot boundary we just crossed.
+        for (int level = 1; level < kLevels; ++level) {
+            if ((m_now & ((std::uint64_t(1) << (kSlotBits * level)) - 1)) != 0) {
+                break;
+            }
+            std::uint32_t slot = static_cast<std::uint32_t>(level) * kSlots +
+                                 static_cast<std::uint32_t>((m_now >> (kSlotBits * level)) & kSlotMask);
+            for (std::uint32_t index = detachSlot(slot); index != kNil;) {
+                std::uint32_t next = m_nodes[index].next;
+                link(index);
+                index = next;
+            }
+        }
+
+        std::uint32_t slot = static_cast<std::uint32_t>(m_now & kSlotMask);
+        for (std::uint32_t index = detachSlot(slot); index != kNil;) {
+            Node& node = m_nodes[index];
+            std::uint32_t next = node.next;
+            node.prev = node.next = node.slot = kNil;
+            if (node.period > 0) {
+                due.push_back(node.entry); // A reference count, not a copy of the task
+                node.expires += node.period;
+                link(index);
+            } else {
+                due.push_back(std::move(node.entry));
+                release(index);
+            }
+            index = next;
+        }
+    }
+
+    // Skips the run if the same periodic task is still running elsewhere.
+    static void runEntry(Entry& entry) {
+        if (entry.running.exchange(true, std::memory_order_acquire)) {
+            return;
+        }
+        entry.task();
+        entry.running.store(false, std::memory_order_release);
+    }
+
+    void runThreadInit() {
+        if (m_threadInit) {
+            m_threadInit();
+        }
+    }
+
+    void driverLoop() {
+        std::vector<EntryPtr> due;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_running) {
+            if (m_active == 0) {
+                m_wake.wait(lock, [this] { return !m_running || m_active > 0; });
+                // Idle time does not count toward timers added afterwards.
+                m_origin = Clock::now() - m_tick * static_cast<long long>(m_now);
+                continue;
+            }
+            Clock::time_point deadline = m_origin + m_tick * static_cast<long long>(m_now + 1);
+            if (m_wake.wait_until(lock, deadline, [this] { return !m_running; })) {
+                break;
+            }
+            // Catch up on every tick that elapsed, e.g. after a slow task.
+            Clock::time_point now = Clock::now();
+            while (m_origin + m_tick * static_cast<long long>(m_now + 1) <= now) {
+                advance(due);
+            }
+            if (due.empty()) {
+                continue;
+            }
+            if (m_workerCount > 1) {
+                for (auto& entry : due) {
+                    m_queue.push_back(std::move(entry));
+                }
+                due.clear();
+                m_workReady.notify_all();
+                continue;
+            }
+            lock.unlock();
+            for (auto& entry : due) {
+                runEntry(*entry);
+            }
+            due.clear();
+            lock.lock();
+        }
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_workReady.wait(lock, [this] { return !m_running || !m_queue.empty(); });
+            if (!m_running) {
+                return;
+            }
+            EntryPtr entry = std::move(m_queue.front());
+            m_queue.pop_front();
+            lock.unlock();
+            runEntry(*entry);
+            lock.lock();
+        }
+    }
+
+    const std::chrono::milliseconds m_tick;
+    const unsigned m_workerCount;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_workReady;
+    bool m_running = false;
+
+    Clock::time_point m_origin;
+    std::uint64_t m_now = 0;
+    std::size_t m_active = 0;
+    std::vector<Node> m_nodes;
+    std::vector<std::uint32_t> m_free;
+    std::array<std::uint32_t, kLevels * kSlots> m_heads;
+
+    std::deque<EntryPtr> m_queue; // Expired tasks awaiting a worker
+    std::function<void()> m_threadInit;
+    std::thread m_driver;
+    std::vector<std::thread> m_workers;
+};
+
+#endif // HVAC_TIMER_WHEEL_H
@@ -0,0 +1,156 @@
+// hvac_zone_store.h
+#ifndef HVAC_ZONE_STORE_H
+#define HVAC_ZONE_STORE_H
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Struct-of-arrays backend for simulating many climate zones at once.
+// Instead of one heap-allocated HVACControl per setting, each field lives in
+// its own contiguous array indexed by zone id, so bulk update and render
+// passes are plain loops with no virtual calls or refcount traffic.
+// Not internally synchronized: one thread owns a store at a time.
+class ZoneClimateStore {
+public:
+    using ZoneId = std::uint32_t;
+
+    enum Mode : std::uint8_t { AC, Heater, Auto };
+
+    static constexpr int kMinTemperature = 15;
+    static constexpr int kMaxTemperature = 30;
+
+    explicit ZoneClimateStore(int fanLimit = 5) : m_fanLimit(fanLimit) {}
+
+    // Mode is a plain enum, so any byte can be cast to it.
+    static bool isValidMode(Mode mode) { return static_cast<std::uint8_t>(mode) <= Auto; }
+
+    void reserve(std::size_t zones) {
+        m_temperatures.reserve(zones);
+        m_fanLevels.reserve(zones);
+        m_modes.reserve(zones);
+        m_dirty.reserve(zones);
+    }
+
+    ZoneId addZone(int temperature = 20, int fanLevel = 1, Mode mode = AC) {
+        m_temperatures.push_back(temperature);
+        m_fanLevels.push_back(static_cast<std::uint8_t>(fanLevel));
+        m_modes.push_back(mode);
+        m_dirty.push_back(1);
+        return static_cast<ZoneId>(m_temperatures.size() - 1);
+    }
+
+    std::size_t size() const { return m_temperatures.size(); }
+
+    // Single-zone accessors apply the same validation as the control screens.
+    // zone must come from addZone(); it is only checked by assert.
+    void setTemperature(ZoneId zone, int temp) {
+        assert(zone < size());
+        if (temp >= kMinTemperature && temp <= kMaxTemperature && m_temperatures[zone] != temp) {
+            m_temperatures[zone] = temp;
+            m_dirty[zone] = 1;
+        }
+    }
+
+    void setFanLevel(ZoneId zone, int level) {
+        assert(zone < size());
+        if (level >= 0 && level <= m_fanLimit && m_fanLevels[zone] != level) {
+            m_fanLevels[zone] = static_cast<std::uint8_t>(level);
+            m_dirty[zone] = 1;
+        }
+    }
+
+    void setMode(ZoneId zone, Mode mode) {
+        assert(zone < size());
+        if (isValidMode(mode) && m_modes[zone] != mode) {
+            m_modes[zone] = mode;
+            m_dirty[zone] = 1;
+        }
+    }
+
+    int getTemperature(ZoneId zone) const {
+        assert(zone < size());
+        return m_temperatures[zone];
+    }
+    int getFanLevel(ZoneId zone) const {
+        assert(zone < size());
+        return m_fanLevels[zone];
+    }
+    Mode getMode(ZoneId zone) const {
+        assert(zone < size());
+        return static_cast<Mode>(m_modes[zone]);
+    }
+
+    // Raw column access for callers that run their own vectorizable loops.
+    int* temperatures() { return m_temperatures.data(); }
+    std::uint8_t* fanLevels() { return m_fanLevels.data(); }
+    std::uint8_t* modes() { return m_modes.data(); }
+
+    // Bulk temperature pass: next = fn(current) for every zone.
+    // Out-of-range results are rejected like setTemperature() would.
+    template <typename Fn>
+    void updateTemperatures(Fn fn) {
+        const std::size_t n = m_temperatures.size();
+        int* temps = m_temperatures.data();
+        std::uint8_t* dirty = m_dirty.data();
+        for (std::size_t i = 0; i < n; ++i) {
+            int next = fn(temps[i]);
+            bool valid = next >= kMinTemperature && next <= kMaxTemperature;
+            bool changed = valid && next != temps[i];
+            temps[i] = changed ? next : temps[i];
+            dirty[i] |= static_cast<std::uint8_t>(changed);
+        }
+    }
+
+    // Bulk fan/mode pass from caller-provided columns of size() entries.
+    void assignFanLevels(const std::uint8_t* levels) {
+        const std::size_t n = m_fanLevels.size();
+        const std::uint8_t limit = static_cast<std::uint8_t>(m_fanLimit);
+        for (std::size_t i = 0; i < n; ++i) {
+            bool changed = levels[i] <= limit && levels[i] != m_fanLevels[i];
+            m_fanLevels[i] = changed ? levels[i] : m_fanLevels[i];
+            m_dirty[i] |= static_cast<std::uint8_t>(changed);
+        }
+    }
+
+    void assignModes(const std::uint8_t* modes) {
+        const std::size_t n = m_modes.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            bool changed = modes[i] <= Auto && modes[i] != m_modes[i];
+            m_modes[i] = changed ? modes[i] : m_modes[i];
+            m_dirty[i] |= static_cast<std::uint8_t>(changed);
+        }
+    }
+
+    // Appends one status line per zone changed since the last render and
+    // clears the dirty flags. Returns the number of zones written.
+    std::size_t renderAll(std::string& out) {
+        static const char* const kModeNames[] = {"AC", "Heater", "Auto"};
+        const std::size_t n = m_temperatures.size();
+        std::size_t drawn = 0;
+        char line[96];
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!m_dirty[i]) {
+                continue;
+            }
+            m_dirty[i] = 0;
+            int len = std::snprintf(line, sizeof(line), "[Zone %zu] Temp: %d°C Fan: Level %d Mode: %s\n",
+                                    i, m_temperatures[i], static_cast<int>(m_fanLevels[i]),
+                                    kModeNames[m_modes[i] <= Auto ? m_modes[i] : static_cast<std::uint8_t>(Auto)]);
+            out.append(line, static_cast<std::size_t>(len));
+            ++drawn;
+        }
+        return drawn;
+    }
+
+private:
+    int m_fanLimit;
+    std::vector<int> m_temperatures;
+    std::vector<std::uint8_t> m_fanLevels;
+    std::vector<std::uint8_t> m_modes;
+    std::vector<std::uint8_t> m_dirty; // 1 = changed since last renderAll()
+};
+
+#endif // HVAC_ZONE_STORE_H